@@ -2,6 +2,25 @@
 #include "mathutils.h"
 #include <float.h>
 #include <string.h>
+#include <time.h>
+#include <algorithm>
+
+#if defined( __BMI2__ ) || defined( __F16C__ )
+#	include <immintrin.h>
+#endif
+
+#if defined( _OPENMP )
+#	include <omp.h>
+#	define MU_PRAGMA( x ) _Pragma( #x )
+#else
+#	define MU_PRAGMA( x )
+#endif
+
+/// loops over independent elements, split across threads when built with OpenMP
+#define MU_PARALLEL_FOR MU_PRAGMA( omp parallel for schedule( static ) )
+
+/// ranges smaller than this are not worth a thread of their own
+#define MU_PARALLEL_GRAIN 4096
 
 #ifndef MU_EPSILON
 #define MU_EPSILON DBL_MIN
@@ -9,6 +28,9 @@
 
 #define MU_DEBUG 0
 
+/// determinant below which a ray is considered parallel to a triangle
+#define MU_RAY_EPSILON 1e-12
+
 #if MU_DEBUG
 #	define EMIT_WARNING( file, line, message ) std::cerr << "warning: " << file << ":" << line << " - " << message << std::endl; 
 #else
@@ -357,10 +379,6 @@
 		return( v1.dot( v2 ) );
 	}
 		
-	double dot( const Vec3 & v1, const Vec3 & v2 ){
-		return( v1.dot( v2 ) );
-	}
-		
 	double dot( const Vec4 & v1, const Vec4 & v2 ){
 		return( v1.dot( v2 ) );
 	}
@@ -369,10 +387,6 @@
 		return( dot( v1.cross(), v2 ) );
 	}
 
-	Vec3 cross( const Vec3 & v1, const Vec3 & v2 ){
-		return( v1.cross( v2 ) );
-	}
-		
 	double mix( double f1, double f2, double f ){
 		return( f2 * f + f1 * ( 1.0 - f ) );
 	}
@@ -944,6 +958,15 @@
 		m_v[ 3 ] = 1.0;
 	}
 
+	void Mat2::setRotation( double radians ){
+		double c = cos( radians );
+		double s = sin( radians );
+		m_v[ 0 ] = c;
+		m_v[ 1 ] = s;
+		m_v[ 2 ] = -s;
+		m_v[ 3 ] = c;
+	}
+
 	Mat2 Mat2::fromIdentity( void ){
 		Mat2 m;
 		m.setIdentity();
@@ -969,14 +992,107 @@
 		return( m );
 	}
 
-	///--------------------------------Vec3-------------------------------
+	///--------------------------------Affine2----------------------------
 
-	Vec3::Vec3( double x, double y, double z ){
-		m_v[ 0 ] = x;
-		m_v[ 1 ] = y;
-		m_v[ 2 ] = z;
+	Affine2::Affine2( const Mat2 & linear, const Vec2 & translation ) :
+		m_linear( linear ),
+		m_translation( translation ){
+	}
+
+	Vec2 Affine2::operator * ( const Vec2 & b ) const {
+		return( Vec2(	m_linear[ 0 ] * b[ 0 ] + m_linear[ 2 ] * b[ 1 ] + m_translation[ 0 ],
+						m_linear[ 1 ] * b[ 0 ] + m_linear[ 3 ] * b[ 1 ] + m_translation[ 1 ] ) );
+	}
+
+	Affine2 Affine2::operator * ( const Affine2 & b ) const {
+		return( Affine2( m_linear * b.m_linear, * this * b.m_translation ) );
+	}
+
+	Affine2 & Affine2::operator *= ( const Affine2 & b ){
+		return( * this = * this * b );
+	}
+
+	Mat2 & Affine2::linear( void ){
+		return( m_linear );
+	}
+
+	const Mat2 & Affine2::linear( void ) const {
+		return( m_linear );
+	}
+
+	Vec2 & Affine2::translation( void ){
+		return( m_translation );
+	}
+
+	const Vec2 & Affine2::translation( void ) const {
+		return( m_translation );
+	}
+
+	/// applies the linear part only
+	Vec2 Affine2::transformVector( const Vec2 & b ) const {
+		return( m_linear * b );
+	}
+
+	Affine2 Affine2::inverse( void ) const {
+		Mat2 inverse = m_linear.inverse();
+		return( Affine2( inverse, -( inverse * m_translation ) ) );
+	}
+
+	/// homogeneous form, translation in the third column
+	Mat3 Affine2::toMat3( void ) const {
+		return( Mat3(	m_linear[ 0 ], m_linear[ 1 ], 0.0,
+						m_linear[ 2 ], m_linear[ 3 ], 0.0,
+						m_translation[ 0 ], m_translation[ 1 ], 1.0 ) );
+	}
+
+	Affine2 Affine2::fromRotateScaleTranslate( double radians, const Vec2 & scale, const Vec2 & translation ){
+		double c = cos( radians );
+		double s = sin( radians );
+		return( Affine2( Mat2( c * scale[ 0 ], s * scale[ 0 ], -s * scale[ 1 ], c * scale[ 1 ] ), translation ) );
+	}
+
+	/// the coefficients are hoisted into locals so the loops see no aliasing and vectorize
+	void transform( const Affine2 & transform, const Vec2 * points, int count, Vec2 * out ){
+		const Mat2 & m = transform.linear();
+		const double a = m[ 0 ], b = m[ 1 ], c = m[ 2 ], d = m[ 3 ];
+		const double tx = transform.translation()[ 0 ], ty = transform.translation()[ 1 ];
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			double x = points[ i ][ 0 ], y = points[ i ][ 1 ];
+			out[ i ] = Vec2( a * x + c * y + tx, b * x + d * y + ty );
+		}
 	}
 
+	void transform( const Affine2 * transforms, int transformCount, const Vec2 * local, int localCount, Vec2 * out ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( ( long long )transformCount * localCount > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < transformCount; i++ ){
+			const Mat2 & m = transforms[ i ].linear();
+			const double a = m[ 0 ], b = m[ 1 ], c = m[ 2 ], d = m[ 3 ];
+			const double tx = transforms[ i ].translation()[ 0 ], ty = transforms[ i ].translation()[ 1 ];
+			Vec2 * corner = out + ( size_t )i * localCount;
+			for( int j = 0; j < localCount; j++ ){
+				double x = local[ j ][ 0 ], y = local[ j ][ 1 ];
+				corner[ j ] = Vec2( a * x + c * y + tx, b * x + d * y + ty );
+			}
+		}
+	}
+
+	void compose( const Affine2 * a, const Affine2 * b, int count, Affine2 * out ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			out[ i ] = a[ i ] * b[ i ];
+		}
+	}
+
+	void fromRotateScaleTranslate( const double * radians, const Vec2 * scales, const Vec2 * translations, int count, Affine2 * out ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			out[ i ] = Affine2::fromRotateScaleTranslate( radians[ i ], scales[ i ], translations[ i ] );
+		}
+	}
+
+	///--------------------------------Vec3-------------------------------
+
 	Vec3::Vec3( double xyz ){
 		m_v[ 0 ] = xyz;
 		m_v[ 1 ] = xyz;
@@ -1164,10 +1280,6 @@
 		return( a );
 	}
 
-	double Vec3::dot( const Vec3 & b ) const {
-		return( m_v[ 0 ] * b[ 0 ] + m_v[ 1 ] * b[ 1 ] + m_v[ 2 ] * b[ 2 ] );
-	}
-
 	Vec3 Vec3::abs( void ) const {
 		return( Vec3( fabs( m_v[ 0 ] ), fabs( m_v[ 1 ] ), fabs( m_v[ 2 ] ) ) );
 	}
@@ -1189,14 +1301,6 @@
 		return( v );
 	}
 
-	Vec3 Vec3::cross( const Vec3 & b ) const {
-		Vec3 a;
-		a[ 0 ] = m_v[ 1 ] * b[ 2 ] - m_v[ 2 ] * b[ 1 ];
-		a[ 1 ] = m_v[ 2 ] * b[ 0 ] - m_v[ 0 ] * b[ 2 ];
-		a[ 2 ] = m_v[ 0 ] * b[ 1 ] - m_v[ 1 ] * b[ 0 ];
-		return( a );
-	}
-
 	bool Vec3::equals( const Vec3 & compare, double epsilon ) const {
 		return( equals( ( const double * )compare, epsilon ) );
 	}
@@ -1695,6 +1799,176 @@
 		return( adjugate().transpose() / d );
 	}
 
+	/// one cyclic Jacobi rotation annihilating a[ p ][ q ] of a symmetric matrix, r is the
+	/// remaining index. The select on den replaces the usual a[ p ][ q ] == 0 branch.
+	static inline void jacobiRotate( double & app, double & aqq, double & apq, double & arp, double & arq, double * vp, double * vq ){
+		double tau = aqq - app;
+		double w = 2.0 * apq;
+		double den = fabs( tau ) + sqrt( tau * tau + w * w );
+		double t = den > DBL_MIN ? ( tau < 0.0 ? -w : w ) / den : 0.0;
+		double c = 1.0 / sqrt( 1.0 + t * t );
+		double s = t * c;
+		app -= t * apq;
+		aqq += t * apq;
+		apq = 0.0;
+		double rp = arp;
+		double rq = arq;
+		arp = c * rp - s * rq;
+		arq = s * rp + c * rq;
+		for( int k = 0; k < 3; k++ ){
+			double kp = vp[ k ];
+			double kq = vq[ k ];
+			vp[ k ] = c * kp - s * kq;
+			vq[ k ] = s * kp + c * kq;
+		}
+	}
+
+	/// Jacobi sweeps over N symmetric matrices at once, a holds the unique elements
+	/// 00, 11, 22, 01, 02, 12 and v the column-major eigenvectors, lane by lane. The number
+	/// of sweeps is fixed so that every lane runs the same instruction stream.
+	template< int N >
+	static void jacobiEigen( double ( * a )[ N ], double ( * v )[ N ] ){
+		for( int sweep = 0; sweep < 6; sweep++ ){
+			for( int i = 0; i < N; i++ ){
+				double v0[ 3 ] = { v[ 0 ][ i ], v[ 1 ][ i ], v[ 2 ][ i ] };
+				double v1[ 3 ] = { v[ 3 ][ i ], v[ 4 ][ i ], v[ 5 ][ i ] };
+				double v2[ 3 ] = { v[ 6 ][ i ], v[ 7 ][ i ], v[ 8 ][ i ] };
+				jacobiRotate( a[ 0 ][ i ], a[ 1 ][ i ], a[ 3 ][ i ], a[ 4 ][ i ], a[ 5 ][ i ], v0, v1 );
+				jacobiRotate( a[ 0 ][ i ], a[ 2 ][ i ], a[ 4 ][ i ], a[ 3 ][ i ], a[ 5 ][ i ], v0, v2 );
+				jacobiRotate( a[ 1 ][ i ], a[ 2 ][ i ], a[ 5 ][ i ], a[ 3 ][ i ], a[ 4 ][ i ], v1, v2 );
+				for( int k = 0; k < 3; k++ ){
+					v[ k ][ i ] = v0[ k ];
+					v[ 3 + k ][ i ] = v1[ k ];
+					v[ 6 + k ][ i ] = v2[ k ];
+				}
+			}
+		}
+	}
+
+	template< int N >
+	static void loadSymmetric( const Mat3 & m, int lane, double ( * a )[ N ], double ( * v )[ N ] ){
+		a[ 0 ][ lane ] = m[ 0 ];
+		a[ 1 ][ lane ] = m[ 4 ];
+		a[ 2 ][ lane ] = m[ 8 ];
+		a[ 3 ][ lane ] = 0.5 * ( m[ 3 ] + m[ 1 ] );
+		a[ 4 ][ lane ] = 0.5 * ( m[ 6 ] + m[ 2 ] );
+		a[ 5 ][ lane ] = 0.5 * ( m[ 7 ] + m[ 5 ] );
+		for( int k = 0; k < 9; k++ ){
+			v[ k ][ lane ] = k % 4 == 0 ? 1.0 : 0.0;
+		}
+	}
+
+	/// sort a lane by descending eigenvalue and make the eigenvector basis right handed
+	template< int N >
+	static void storeEigen( double ( * a )[ N ], double ( * v )[ N ], int lane, Vec3 & values, Mat3 & vectors ){
+		int order[ 3 ] = { 0, 1, 2 };
+		for( int i = 0; i < 2; i++ ){
+			for( int j = 2; j > i; j-- ){
+				if( a[ order[ j ] ][ lane ] > a[ order[ j - 1 ] ][ lane ] ){
+					std::swap( order[ j ], order[ j - 1 ] );
+				}
+			}
+		}
+		for( int c = 0; c < 3; c++ ){
+			values[ c ] = a[ order[ c ] ][ lane ];
+			for( int k = 0; k < 3; k++ ){
+				vectors[ c * 3 + k ] = v[ order[ c ] * 3 + k ][ lane ];
+			}
+		}
+		if( vectors.determinant() < 0.0 ){
+			vectors[ 6 ] = -vectors[ 6 ];
+			vectors[ 7 ] = -vectors[ 7 ];
+			vectors[ 8 ] = -vectors[ 8 ];
+		}
+	}
+
+	/// U from B = A V by Gram-Schmidt, the third column is completed by a cross product so that U
+	/// is a rotation and the last singular value carries the sign of the determinant
+	static void completeSvd( const Mat3 & m, const Mat3 & v, Mat3 & u, Vec3 & sigma ){
+		Vec3 b0 = m * v.getCol( 0 );
+		Vec3 b1 = m * v.getCol( 1 );
+		Vec3 b2 = m * v.getCol( 2 );
+		double s0 = sqrt( b0.hyp() );
+		Vec3 u0 = s0 > DBL_MIN ? b0 / s0 : v.getCol( 0 );
+		Vec3 r1 = b1 - u0 * u0.dot( b1 );
+		// second pass, b1 may be nearly parallel to u0
+		r1 -= u0 * u0.dot( r1 );
+		double s1 = sqrt( r1.hyp() );
+		Vec3 u1;
+		if( s1 > DBL_MIN ){
+			u1 = r1 / s1;
+		}
+		else{
+			// rank one or zero, any unit vector orthogonal to u0 will do
+			Vec3 axis = fabs( u0[ 0 ] ) < 0.6 ? Vec3( 1.0, 0.0, 0.0 ) : Vec3( 0.0, 1.0, 0.0 );
+			u1 = axis - u0 * u0.dot( axis );
+			u1 /= sqrt( u1.hyp() );
+		}
+		Vec3 u2 = u0.cross( u1 );
+		u = Mat3( u0, u1, u2 );
+		sigma = Vec3( s0, u1.dot( b1 ), u2.dot( b2 ) );
+	}
+
+	/// eigenvalues in descending order, the eigenvectors are the matching columns and form a
+	/// rotation. Only the symmetric part of the matrix is considered.
+	void Mat3::eigenSymmetric( Vec3 & eigenvalues, Mat3 & eigenvectors ) const {
+		double a[ 6 ][ 1 ], v[ 9 ][ 1 ];
+		loadSymmetric( * this, 0, a, v );
+		jacobiEigen( a, v );
+		storeEigen( a, v, 0, eigenvalues, eigenvectors );
+	}
+
+	/// this = u * diag( sigma ) * v^T with u and v rotations and sigma in descending order of
+	/// magnitude. sigma[ 2 ] is negative when the determinant is, which keeps u and v proper
+	/// rotations as wanted by polar decomposition and rigid registration.
+	void Mat3::svd( Mat3 & u, Vec3 & sigma, Mat3 & v ) const {
+		Vec3 lambda;
+		( transpose() * ( * this ) ).eigenSymmetric( lambda, v );
+		completeSvd( * this, v, u, sigma );
+	}
+
+	void eigenSymmetric( const Mat3 * matrices, int count, Vec3 * eigenvalues, Mat3 * eigenvectors ){
+		int packets = ( count + MU_PACKET_SIZE - 1 ) / MU_PACKET_SIZE;
+		MU_PARALLEL_FOR
+		for( int packet = 0; packet < packets; packet++ ){
+			double a[ 6 ][ MU_PACKET_SIZE ], v[ 9 ][ MU_PACKET_SIZE ];
+			int base = packet * MU_PACKET_SIZE;
+			int lanes = count - base < MU_PACKET_SIZE ? count - base : MU_PACKET_SIZE;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				loadSymmetric( matrices[ base + ( i < lanes ? i : 0 ) ], i, a, v );
+			}
+			jacobiEigen( a, v );
+			for( int i = 0; i < lanes; i++ ){
+				storeEigen( a, v, i, eigenvalues[ base + i ], eigenvectors[ base + i ] );
+			}
+		}
+	}
+
+	/// svd of up to MU_PACKET_SIZE matrices in one pass of the lane kernel
+	static void svdPacket( const Mat3 * matrices, int lanes, Mat3 * u, Vec3 * sigma, Mat3 * v ){
+		double a[ 6 ][ MU_PACKET_SIZE ], w[ 9 ][ MU_PACKET_SIZE ];
+		for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+			const Mat3 & m = matrices[ i < lanes ? i : 0 ];
+			loadSymmetric( m.transpose() * m, i, a, w );
+		}
+		jacobiEigen( a, w );
+		for( int i = 0; i < lanes; i++ ){
+			Vec3 lambda;
+			storeEigen( a, w, i, lambda, v[ i ] );
+			completeSvd( matrices[ i ], v[ i ], u[ i ], sigma[ i ] );
+		}
+	}
+
+	void svd( const Mat3 * matrices, int count, Mat3 * u, Vec3 * sigma, Mat3 * v ){
+		int packets = ( count + MU_PACKET_SIZE - 1 ) / MU_PACKET_SIZE;
+		MU_PARALLEL_FOR
+		for( int packet = 0; packet < packets; packet++ ){
+			int base = packet * MU_PACKET_SIZE;
+			int lanes = count - base < MU_PACKET_SIZE ? count - base : MU_PACKET_SIZE;
+			svdPacket( matrices + base, lanes, u + base, sigma + base, v + base );
+		}
+	}
+
   Mat3 Mat3::fromRowMajor( double r0c0, double r0c1, double r0c2, double r1c0, double r1c1, double r1c2, double r2c0, double r2c1, double r2c2 ){
 		Mat3 m;
 		m.setElement( 0, 0, r0c0 );
@@ -3460,6 +3734,59 @@
 		return( r );
 	}
 
+	/// rotation and stretch of the polar decomposition A = R * S from the svd A = U * E * V^T:
+	/// R = U * V^T and S = V * E * V^T. As U and V are rotations, so is R, and a reflection
+	/// shows up as a negative eigenvalue of S.
+	static void polarParts( const Mat3 & u, const Vec3 & sigma, const Mat3 & v, Quat & rotation, Vec3 & scale, Vec3 & shear ){
+		Mat3 r = u * v.transpose();
+		Mat3 e( sigma[ 0 ], 0.0, 0.0, 0.0, sigma[ 1 ], 0.0, 0.0, 0.0, sigma[ 2 ] );
+		Mat3 stretch = v * e * v.transpose();
+		rotation = Quat::fromMat3( r );
+		rotation.normalize();
+		scale = Vec3( stretch[ 0 ], stretch[ 4 ], stretch[ 8 ] );
+		shear = Vec3( stretch[ 3 ], stretch[ 6 ], stretch[ 7 ] );
+	}
+
+	/// split an affine matrix into translation, rotation and the symmetric stretch of its polar
+	/// decomposition, upper 3x3 = rotation * [ scale.x shear.x shear.y; shear.x scale.y shear.z;
+	/// shear.y shear.z scale.z ]. Rebuild with fromDecomposition.
+	void Mat4::decompose( Vec3 & translation, Quat & rotation, Vec3 & scale, Vec3 & shear ) const {
+		Mat3 u, v;
+		Vec3 sigma;
+		toMat3().svd( u, sigma, v );
+		polarParts( u, sigma, v, rotation, scale, shear );
+		translation = Vec3( m_v[ 12 ], m_v[ 13 ], m_v[ 14 ] );
+	}
+
+	Mat4 Mat4::fromDecomposition( const Vec3 & translation, const Quat & rotation, const Vec3 & scale, const Vec3 & shear ){
+		Mat3 stretch(	scale[ 0 ], shear[ 0 ], shear[ 1 ],
+						shear[ 0 ], scale[ 1 ], shear[ 2 ],
+						shear[ 1 ], shear[ 2 ], scale[ 2 ] );
+		Mat4 m;
+		m = rotation.toMat3() * stretch;
+		m.setTranslation( translation );
+		return( m );
+	}
+
+	void decompose( const Mat4 * matrices, int count, Vec3 * translations, Quat * rotations, Vec3 * scales, Vec3 * shears ){
+		int packets = ( count + MU_PACKET_SIZE - 1 ) / MU_PACKET_SIZE;
+		MU_PARALLEL_FOR
+		for( int packet = 0; packet < packets; packet++ ){
+			Mat3 m[ MU_PACKET_SIZE ], u[ MU_PACKET_SIZE ], v[ MU_PACKET_SIZE ];
+			Vec3 sigma[ MU_PACKET_SIZE ];
+			int base = packet * MU_PACKET_SIZE;
+			int lanes = count - base < MU_PACKET_SIZE ? count - base : MU_PACKET_SIZE;
+			for( int i = 0; i < lanes; i++ ){
+				m[ i ] = matrices[ base + i ].rotation();
+			}
+			svdPacket( m, lanes, u, sigma, v );
+			for( int i = 0; i < lanes; i++ ){
+				polarParts( u[ i ], sigma[ i ], v[ i ], rotations[ base + i ], scales[ base + i ], shears[ base + i ] );
+				translations[ base + i ] = matrices[ base + i ].translation();
+			}
+		}
+	}
+
 	Mat4 Mat4::fromTranslation( const Vec3 & translation ){
 		Mat4 m;
 		m.setTranslation( translation );
@@ -3916,6 +4243,4986 @@
 		translate( -eye );
 	}
 
+	///--------------------------------Ray--------------------------------
+
+	Ray::Ray( const Vec3 & origin, const Vec3 & direction ) :
+		m_origin( origin ),
+		m_direction( direction ){
+	}
+
+	Vec3 & Ray::origin( void ){
+		return( m_origin );
+	}
+
+	const Vec3 & Ray::origin( void ) const {
+		return( m_origin );
+	}
+
+	Vec3 & Ray::direction( void ){
+		return( m_direction );
+	}
+
+	const Vec3 & Ray::direction( void ) const {
+		return( m_direction );
+	}
+
+	Vec3 Ray::at( double t ) const {
+		return( m_origin + m_direction * t );
+	}
+
+	/// Moeller-Trumbore, shared by the ray and segment tests, hits are accepted for t in [ 0, tMax ]
+	static bool intersectTriangle( const Vec3 & o, const Vec3 & d, double tMax, const Vec3 & v0, const Vec3 & v1, const Vec3 & v2, double & t, double & u, double & v ){
+		Vec3 e1 = v1 - v0;
+		Vec3 e2 = v2 - v0;
+		Vec3 p = d.cross( e2 );
+		double det = e1.dot( p );
+		if( fabs( det ) < MU_RAY_EPSILON ){
+			return( false );
+		}
+		double inv = 1.0 / det;
+		Vec3 s = o - v0;
+		double bu = s.dot( p ) * inv;
+		if( bu < 0.0 || bu > 1.0 ){
+			return( false );
+		}
+		Vec3 q = s.cross( e1 );
+		double bv = d.dot( q ) * inv;
+		if( bv < 0.0 || bu + bv > 1.0 ){
+			return( false );
+		}
+		double bt = e2.dot( q ) * inv;
+		if( bt < 0.0 || bt > tMax ){
+			return( false );
+		}
+		t = bt;
+		u = bu;
+		v = bv;
+		return( true );
+	}
+
+	/// slab test, returns the raw entry and exit distances
+	static bool intersectBox( const Vec3 & o, const Vec3 & d, double tMax, const Vec3 & boxMin, const Vec3 & boxMax, double & tNear, double & tFar ){
+		double t0 = -HUGE_VAL;
+		double t1 = HUGE_VAL;
+		for( int i = 0; i < 3; i++ ){
+			double inv = 1.0 / d[ i ];
+			double ta = ( boxMin[ i ] - o[ i ] ) * inv;
+			double tb = ( boxMax[ i ] - o[ i ] ) * inv;
+			if( ta > tb ){
+				double tmp = ta;
+				ta = tb;
+				tb = tmp;
+			}
+			t0 = ta > t0 ? ta : t0;
+			t1 = tb < t1 ? tb : t1;
+		}
+		tNear = t0;
+		tFar = t1;
+		return( t1 >= t0 && t1 >= 0.0 && t0 <= tMax );
+	}
+
+	bool Ray::intersectTriangle( const Vec3 & v0, const Vec3 & v1, const Vec3 & v2, double & t, double & u, double & v ) const {
+		return( mu::intersectTriangle( m_origin, m_direction, HUGE_VAL, v0, v1, v2, t, u, v ) );
+	}
+
+	bool Ray::intersectBox( const Vec3 & boxMin, const Vec3 & boxMax, double & tNear, double & tFar ) const {
+		return( mu::intersectBox( m_origin, m_direction, HUGE_VAL, boxMin, boxMax, tNear, tFar ) );
+	}
+
+	///--------------------------------RaySegment-------------------------
+
+	RaySegment::RaySegment( const Vec3 & start, const Vec3 & end ) :
+		m_start( start ),
+		m_end( end ){
+	}
+
+	Vec3 & RaySegment::start( void ){
+		return( m_start );
+	}
+
+	const Vec3 & RaySegment::start( void ) const {
+		return( m_start );
+	}
+
+	Vec3 & RaySegment::end( void ){
+		return( m_end );
+	}
+
+	const Vec3 & RaySegment::end( void ) const {
+		return( m_end );
+	}
+
+	Vec3 RaySegment::direction( void ) const {
+		return( m_end - m_start );
+	}
+
+	double RaySegment::length( void ) const {
+		return( distance( m_start, m_end ) );
+	}
+
+	Vec3 RaySegment::at( double t ) const {
+		return( m_start + ( m_end - m_start ) * t );
+	}
+
+	Ray RaySegment::toRay( void ) const {
+		return( Ray( m_start, m_end - m_start ) );
+	}
+
+	bool RaySegment::intersectTriangle( const Vec3 & v0, const Vec3 & v1, const Vec3 & v2, double & t, double & u, double & v ) const {
+		return( mu::intersectTriangle( m_start, m_end - m_start, 1.0, v0, v1, v2, t, u, v ) );
+	}
+
+	bool RaySegment::intersectBox( const Vec3 & boxMin, const Vec3 & boxMax, double & tNear, double & tFar ) const {
+		return( mu::intersectBox( m_start, m_end - m_start, 1.0, boxMin, boxMax, tNear, tFar ) );
+	}
+
+	///--------------------------------packet kernels---------------------
+	// The lane loops below are written without branches over structure-of-arrays copies
+	// of MU_PACKET_SIZE rays or primitives, so that the compiler maps each of them onto
+	// one vector instruction per operation. Missing lanes of the last packet replicate
+	// the first element and are ignored when the results are read back.
+
+	static void triangleVertices( const Vec3 * vertices, const int * indices, int triangle, const Vec3 ** v ){
+		if( indices ){
+			v[ 0 ] = & vertices[ indices[ 3 * triangle ] ];
+			v[ 1 ] = & vertices[ indices[ 3 * triangle + 1 ] ];
+			v[ 2 ] = & vertices[ indices[ 3 * triangle + 2 ] ];
+		}
+		else{
+			v[ 0 ] = & vertices[ 3 * triangle ];
+			v[ 1 ] = & vertices[ 3 * triangle + 1 ];
+			v[ 2 ] = & vertices[ 3 * triangle + 2 ];
+		}
+	}
+
+	/// one ray against MU_PACKET_SIZE triangles per pass
+	static int intersectTrianglePackets( const Vec3 & o, const Vec3 & d, double tMax, const Vec3 * vertices, const int * indices, int triangleCount, double & t, double & u, double & v ){
+		double ax[ MU_PACKET_SIZE ], ay[ MU_PACKET_SIZE ], az[ MU_PACKET_SIZE ];
+		double e1x[ MU_PACKET_SIZE ], e1y[ MU_PACKET_SIZE ], e1z[ MU_PACKET_SIZE ];
+		double e2x[ MU_PACKET_SIZE ], e2y[ MU_PACKET_SIZE ], e2z[ MU_PACKET_SIZE ];
+		double lt[ MU_PACKET_SIZE ], lu[ MU_PACKET_SIZE ], lv[ MU_PACKET_SIZE ];
+		bool lhit[ MU_PACKET_SIZE ];
+		const double ox = o[ 0 ], oy = o[ 1 ], oz = o[ 2 ];
+		const double dx = d[ 0 ], dy = d[ 1 ], dz = d[ 2 ];
+		const Vec3 * tv[ 3 ];
+		double best = tMax;
+		int hit = -1;
+
+		for( int base = 0; base < triangleCount; base += MU_PACKET_SIZE ){
+			int lanes = triangleCount - base < MU_PACKET_SIZE ? triangleCount - base : MU_PACKET_SIZE;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				triangleVertices( vertices, indices, base + ( i < lanes ? i : 0 ), tv );
+				ax[ i ] = ( * tv[ 0 ] )[ 0 ];
+				ay[ i ] = ( * tv[ 0 ] )[ 1 ];
+				az[ i ] = ( * tv[ 0 ] )[ 2 ];
+				e1x[ i ] = ( * tv[ 1 ] )[ 0 ] - ax[ i ];
+				e1y[ i ] = ( * tv[ 1 ] )[ 1 ] - ay[ i ];
+				e1z[ i ] = ( * tv[ 1 ] )[ 2 ] - az[ i ];
+				e2x[ i ] = ( * tv[ 2 ] )[ 0 ] - ax[ i ];
+				e2y[ i ] = ( * tv[ 2 ] )[ 1 ] - ay[ i ];
+				e2z[ i ] = ( * tv[ 2 ] )[ 2 ] - az[ i ];
+			}
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				double px = dy * e2z[ i ] - dz * e2y[ i ];
+				double py = dz * e2x[ i ] - dx * e2z[ i ];
+				double pz = dx * e2y[ i ] - dy * e2x[ i ];
+				double det = e1x[ i ] * px + e1y[ i ] * py + e1z[ i ] * pz;
+				double inv = 1.0 / det;
+				double sx = ox - ax[ i ];
+				double sy = oy - ay[ i ];
+				double sz = oz - az[ i ];
+				double bu = ( sx * px + sy * py + sz * pz ) * inv;
+				double qx = sy * e1z[ i ] - sz * e1y[ i ];
+				double qy = sz * e1x[ i ] - sx * e1z[ i ];
+				double qz = sx * e1y[ i ] - sy * e1x[ i ];
+				double bv = ( dx * qx + dy * qy + dz * qz ) * inv;
+				double bt = ( e2x[ i ] * qx + e2y[ i ] * qy + e2z[ i ] * qz ) * inv;
+				bool valid = ( fabs( det ) >= MU_RAY_EPSILON ) & ( bu >= 0.0 ) & ( bv >= 0.0 ) & ( bu + bv <= 1.0 ) & ( bt >= 0.0 ) & ( bt <= tMax );
+				lhit[ i ] = valid;
+				lt[ i ] = bt;
+				lu[ i ] = bu;
+				lv[ i ] = bv;
+			}
+			// misses are masked rather than pushed to HUGE_VAL, which an unbounded ray would
+			// accept against best = tMax
+			for( int i = 0; i < lanes; i++ ){
+				if( lhit[ i ] && lt[ i ] <= best ){
+					best = lt[ i ];
+					u = lu[ i ];
+					v = lv[ i ];
+					hit = base + i;
+				}
+			}
+		}
+		if( hit >= 0 ){
+			t = best;
+		}
+		return( hit );
+	}
+
+	static Vec3 rayOrigin( const Ray & r ){
+		return( r.origin() );
+	}
+
+	static Vec3 rayDirection( const Ray & r ){
+		return( r.direction() );
+	}
+
+	static Vec3 rayOrigin( const RaySegment & r ){
+		return( r.start() );
+	}
+
+	static Vec3 rayDirection( const RaySegment & r ){
+		return( r.direction() );
+	}
+
+	/// MU_PACKET_SIZE rays against one triangle per pass
+	template< class R >
+	static void intersectRayPackets( const R * rays, int rayCount, double tMax, const Vec3 & v0, const Vec3 & v1, const Vec3 & v2, double * t ){
+		double ox[ MU_PACKET_SIZE ], oy[ MU_PACKET_SIZE ], oz[ MU_PACKET_SIZE ];
+		double dx[ MU_PACKET_SIZE ], dy[ MU_PACKET_SIZE ], dz[ MU_PACKET_SIZE ];
+		double lt[ MU_PACKET_SIZE ];
+		const Vec3 e1 = v1 - v0;
+		const Vec3 e2 = v2 - v0;
+
+		for( int base = 0; base < rayCount; base += MU_PACKET_SIZE ){
+			int lanes = rayCount - base < MU_PACKET_SIZE ? rayCount - base : MU_PACKET_SIZE;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				const R & r = rays[ base + ( i < lanes ? i : 0 ) ];
+				Vec3 o = rayOrigin( r );
+				Vec3 d = rayDirection( r );
+				ox[ i ] = o[ 0 ];
+				oy[ i ] = o[ 1 ];
+				oz[ i ] = o[ 2 ];
+				dx[ i ] = d[ 0 ];
+				dy[ i ] = d[ 1 ];
+				dz[ i ] = d[ 2 ];
+			}
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				double px = dy[ i ] * e2[ 2 ] - dz[ i ] * e2[ 1 ];
+				double py = dz[ i ] * e2[ 0 ] - dx[ i ] * e2[ 2 ];
+				double pz = dx[ i ] * e2[ 1 ] - dy[ i ] * e2[ 0 ];
+				double det = e1[ 0 ] * px + e1[ 1 ] * py + e1[ 2 ] * pz;
+				double inv = 1.0 / det;
+				double sx = ox[ i ] - v0[ 0 ];
+				double sy = oy[ i ] - v0[ 1 ];
+				double sz = oz[ i ] - v0[ 2 ];
+				double bu = ( sx * px + sy * py + sz * pz ) * inv;
+				double qx = sy * e1[ 2 ] - sz * e1[ 1 ];
+				double qy = sz * e1[ 0 ] - sx * e1[ 2 ];
+				double qz = sx * e1[ 1 ] - sy * e1[ 0 ];
+				double bv = ( dx[ i ] * qx + dy[ i ] * qy + dz[ i ] * qz ) * inv;
+				double bt = ( e2[ 0 ] * qx + e2[ 1 ] * qy + e2[ 2 ] * qz ) * inv;
+				bool valid = ( fabs( det ) >= MU_RAY_EPSILON ) & ( bu >= 0.0 ) & ( bv >= 0.0 ) & ( bu + bv <= 1.0 ) & ( bt >= 0.0 ) & ( bt <= tMax );
+				lt[ i ] = valid ? bt : -1.0;
+			}
+			for( int i = 0; i < lanes; i++ ){
+				t[ base + i ] = lt[ i ];
+			}
+		}
+	}
+
+	/// one ray against MU_PACKET_SIZE boxes per pass
+	static int intersectBoxPackets( const Vec3 & o, const Vec3 & d, double tMax, const Vec3 * boxMin, const Vec3 * boxMax, int boxCount, double * tNear ){
+		double lx0[ MU_PACKET_SIZE ], ly0[ MU_PACKET_SIZE ], lz0[ MU_PACKET_SIZE ];
+		double lx1[ MU_PACKET_SIZE ], ly1[ MU_PACKET_SIZE ], lz1[ MU_PACKET_SIZE ];
+		double lt[ MU_PACKET_SIZE ];
+		const double ix = 1.0 / d[ 0 ], iy = 1.0 / d[ 1 ], iz = 1.0 / d[ 2 ];
+		double best = HUGE_VAL;
+		int hit = -1;
+
+		for( int base = 0; base < boxCount; base += MU_PACKET_SIZE ){
+			int lanes = boxCount - base < MU_PACKET_SIZE ? boxCount - base : MU_PACKET_SIZE;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				int box = base + ( i < lanes ? i : 0 );
+				lx0[ i ] = boxMin[ box ][ 0 ];
+				ly0[ i ] = boxMin[ box ][ 1 ];
+				lz0[ i ] = boxMin[ box ][ 2 ];
+				lx1[ i ] = boxMax[ box ][ 0 ];
+				ly1[ i ] = boxMax[ box ][ 1 ];
+				lz1[ i ] = boxMax[ box ][ 2 ];
+			}
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				double xa = ( lx0[ i ] - o[ 0 ] ) * ix, xb = ( lx1[ i ] - o[ 0 ] ) * ix;
+				double ya = ( ly0[ i ] - o[ 1 ] ) * iy, yb = ( ly1[ i ] - o[ 1 ] ) * iy;
+				double za = ( lz0[ i ] - o[ 2 ] ) * iz, zb = ( lz1[ i ] - o[ 2 ] ) * iz;
+				double t0 = xa < xb ? xa : xb;
+				double t1 = xa < xb ? xb : xa;
+				double ymin = ya < yb ? ya : yb, ymax = ya < yb ? yb : ya;
+				double zmin = za < zb ? za : zb, zmax = za < zb ? zb : za;
+				t0 = ymin > t0 ? ymin : t0;
+				t0 = zmin > t0 ? zmin : t0;
+				t0 = t0 > 0.0 ? t0 : 0.0;
+				t1 = ymax < t1 ? ymax : t1;
+				t1 = zmax < t1 ? zmax : t1;
+				lt[ i ] = ( t1 >= t0 ) & ( t0 <= tMax ) ? t0 : -1.0;
+			}
+			for( int i = 0; i < lanes; i++ ){
+				tNear[ base + i ] = lt[ i ];
+				if( lt[ i ] >= 0.0 && lt[ i ] < best ){
+					best = lt[ i ];
+					hit = base + i;
+				}
+			}
+		}
+		return( hit );
+	}
+
+	/// MU_PACKET_SIZE rays against one box per pass
+	template< class R >
+	static void intersectBoxRayPackets( const R * rays, int rayCount, double tMax, const Vec3 & boxMin, const Vec3 & boxMax, double * tNear ){
+		double ox[ MU_PACKET_SIZE ], oy[ MU_PACKET_SIZE ], oz[ MU_PACKET_SIZE ];
+		double ix[ MU_PACKET_SIZE ], iy[ MU_PACKET_SIZE ], iz[ MU_PACKET_SIZE ];
+		double lt[ MU_PACKET_SIZE ];
+
+		for( int base = 0; base < rayCount; base += MU_PACKET_SIZE ){
+			int lanes = rayCount - base < MU_PACKET_SIZE ? rayCount - base : MU_PACKET_SIZE;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				const R & r = rays[ base + ( i < lanes ? i : 0 ) ];
+				Vec3 o = rayOrigin( r );
+				Vec3 d = rayDirection( r );
+				ox[ i ] = o[ 0 ];
+				oy[ i ] = o[ 1 ];
+				oz[ i ] = o[ 2 ];
+				ix[ i ] = 1.0 / d[ 0 ];
+				iy[ i ] = 1.0 / d[ 1 ];
+				iz[ i ] = 1.0 / d[ 2 ];
+			}
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				double xa = ( boxMin[ 0 ] - ox[ i ] ) * ix[ i ], xb = ( boxMax[ 0 ] - ox[ i ] ) * ix[ i ];
+				double ya = ( boxMin[ 1 ] - oy[ i ] ) * iy[ i ], yb = ( boxMax[ 1 ] - oy[ i ] ) * iy[ i ];
+				double za = ( boxMin[ 2 ] - oz[ i ] ) * iz[ i ], zb = ( boxMax[ 2 ] - oz[ i ] ) * iz[ i ];
+				double t0 = xa < xb ? xa : xb;
+				double t1 = xa < xb ? xb : xa;
+				double ymin = ya < yb ? ya : yb, ymax = ya < yb ? yb : ya;
+				double zmin = za < zb ? za : zb, zmax = za < zb ? zb : za;
+				t0 = ymin > t0 ? ymin : t0;
+				t0 = zmin > t0 ? zmin : t0;
+				t0 = t0 > 0.0 ? t0 : 0.0;
+				t1 = ymax < t1 ? ymax : t1;
+				t1 = zmax < t1 ? zmax : t1;
+				lt[ i ] = ( t1 >= t0 ) & ( t0 <= tMax ) ? t0 : -1.0;
+			}
+			for( int i = 0; i < lanes; i++ ){
+				tNear[ base + i ] = lt[ i ];
+			}
+		}
+	}
+
+	int intersectTriangles( const Ray & ray, const Vec3 * vertices, const int * indices, int triangleCount, double & t, double & u, double & v ){
+		return( intersectTrianglePackets( ray.origin(), ray.direction(), HUGE_VAL, vertices, indices, triangleCount, t, u, v ) );
+	}
+
+	int intersectTriangles( const RaySegment & segment, const Vec3 * vertices, const int * indices, int triangleCount, double & t, double & u, double & v ){
+		return( intersectTrianglePackets( segment.start(), segment.direction(), 1.0, vertices, indices, triangleCount, t, u, v ) );
+	}
+
+	void intersectTriangle( const Ray * rays, int rayCount, const Vec3 & v0, const Vec3 & v1, const Vec3 & v2, double * t ){
+		intersectRayPackets( rays, rayCount, HUGE_VAL, v0, v1, v2, t );
+	}
+
+	void intersectTriangle( const RaySegment * segments, int segmentCount, const Vec3 & v0, const Vec3 & v1, const Vec3 & v2, double * t ){
+		intersectRayPackets( segments, segmentCount, 1.0, v0, v1, v2, t );
+	}
+
+	int intersectBoxes( const Ray & ray, const Vec3 * boxMin, const Vec3 * boxMax, int boxCount, double * tNear ){
+		return( intersectBoxPackets( ray.origin(), ray.direction(), HUGE_VAL, boxMin, boxMax, boxCount, tNear ) );
+	}
+
+	int intersectBoxes( const RaySegment & segment, const Vec3 * boxMin, const Vec3 * boxMax, int boxCount, double * tNear ){
+		return( intersectBoxPackets( segment.start(), segment.direction(), 1.0, boxMin, boxMax, boxCount, tNear ) );
+	}
+
+	void intersectBox( const Ray * rays, int rayCount, const Vec3 & boxMin, const Vec3 & boxMax, double * tNear ){
+		intersectBoxRayPackets( rays, rayCount, HUGE_VAL, boxMin, boxMax, tNear );
+	}
+
+	void intersectBox( const RaySegment * segments, int segmentCount, const Vec3 & boxMin, const Vec3 & boxMax, double * tNear ){
+		intersectBoxRayPackets( segments, segmentCount, 1.0, boxMin, boxMax, tNear );
+	}
+
+	///--------------------------------KdTree-----------------------------
+
+	struct AxisLess {
+		const Vec3 * points;
+		int axis;
+		bool operator () ( int a, int b ) const {
+			return( points[ a ][ axis ] < points[ b ][ axis ] );
+		}
+	};
+
+	/// split [ lo, hi ) of the index permutation at its middle along the axis of largest extent
+	static void buildKdTree( const Vec3 * points, int * order, unsigned char * axes, int lo, int hi ){
+		if( hi - lo <= 1 ){
+			if( hi > lo ){
+				axes[ lo ] = 0;
+			}
+			return;
+		}
+		Vec3 bmin( points[ order[ lo ] ] );
+		Vec3 bmax( bmin );
+		for( int i = lo + 1; i < hi; i++ ){
+			const Vec3 & p = points[ order[ i ] ];
+			for( int j = 0; j < 3; j++ ){
+				bmin[ j ] = p[ j ] < bmin[ j ] ? p[ j ] : bmin[ j ];
+				bmax[ j ] = p[ j ] > bmax[ j ] ? p[ j ] : bmax[ j ];
+			}
+		}
+		Vec3 extent = bmax - bmin;
+		int axis = 0;
+		if( extent[ 1 ] > extent[ axis ] ){
+			axis = 1;
+		}
+		if( extent[ 2 ] > extent[ axis ] ){
+			axis = 2;
+		}
+		int mid = lo + ( hi - lo ) / 2;
+		AxisLess less;
+		less.points = points;
+		less.axis = axis;
+		std::nth_element( order + lo, order + mid, order + hi, less );
+		axes[ mid ] = ( unsigned char )axis;
+
+		MU_PRAGMA( omp task if( hi - lo > MU_PARALLEL_GRAIN ) )
+		buildKdTree( points, order, axes, lo, mid );
+		MU_PRAGMA( omp task if( hi - lo > MU_PARALLEL_GRAIN ) )
+		buildKdTree( points, order, axes, mid + 1, hi );
+		MU_PRAGMA( omp taskwait )
+	}
+
+	/// bounded max-heap on the distance, kept in the caller's output arrays
+	static void heapPush( int * indices, double * distances2, int & count, int k, int index, double d2 ){
+		int i;
+		if( count < k ){
+			i = count++;
+			while( i > 0 ){
+				int parent = ( i - 1 ) / 2;
+				if( distances2[ parent ] >= d2 ){
+					break;
+				}
+				indices[ i ] = indices[ parent ];
+				distances2[ i ] = distances2[ parent ];
+				i = parent;
+			}
+		}
+		else{
+			// replace the root and sift down
+			i = 0;
+			for( ;; ){
+				int child = 2 * i + 1;
+				if( child >= count ){
+					break;
+				}
+				if( child + 1 < count && distances2[ child + 1 ] > distances2[ child ] ){
+					child++;
+				}
+				if( distances2[ child ] <= d2 ){
+					break;
+				}
+				indices[ i ] = indices[ child ];
+				distances2[ i ] = distances2[ child ];
+				i = child;
+			}
+		}
+		indices[ i ] = index;
+		distances2[ i ] = d2;
+	}
+
+	/// turn the heap into ascending order in place
+	static void heapSort( int * indices, double * distances2, int count ){
+		for( int n = count - 1; n > 0; n-- ){
+			int topIndex = indices[ 0 ];
+			double topDistance = distances2[ 0 ];
+			int lastIndex = indices[ n ];
+			double lastDistance = distances2[ n ];
+			int i = 0;
+			for( ;; ){
+				int child = 2 * i + 1;
+				if( child >= n ){
+					break;
+				}
+				if( child + 1 < n && distances2[ child + 1 ] > distances2[ child ] ){
+					child++;
+				}
+				if( distances2[ child ] <= lastDistance ){
+					break;
+				}
+				indices[ i ] = indices[ child ];
+				distances2[ i ] = distances2[ child ];
+				i = child;
+			}
+			indices[ i ] = lastIndex;
+			distances2[ i ] = lastDistance;
+			indices[ n ] = topIndex;
+			distances2[ n ] = topDistance;
+		}
+	}
+
+	static void searchKdTree( const Vec3 * points, const unsigned char * axes, int lo, int hi, const Vec3 & q, int k, int * indices, double * distances2, int & count ){
+		while( lo < hi ){
+			int mid = lo + ( hi - lo ) / 2;
+			const Vec3 & p = points[ mid ];
+			double dx = q[ 0 ] - p[ 0 ];
+			double dy = q[ 1 ] - p[ 1 ];
+			double dz = q[ 2 ] - p[ 2 ];
+			double d2 = dx * dx + dy * dy + dz * dz;
+			if( count < k || d2 < distances2[ 0 ] ){
+				heapPush( indices, distances2, count, k, mid, d2 );
+			}
+			int axis = axes[ mid ];
+			double diff = q[ axis ] - p[ axis ];
+			int nearLo = diff < 0.0 ? lo : mid + 1;
+			int nearHi = diff < 0.0 ? mid : hi;
+			int farLo = diff < 0.0 ? mid + 1 : lo;
+			int farHi = diff < 0.0 ? hi : mid;
+			searchKdTree( points, axes, nearLo, nearHi, q, k, indices, distances2, count );
+			if( count == k && diff * diff >= distances2[ 0 ] ){
+				return;
+			}
+			// continue with the far side without recursing
+			lo = farLo;
+			hi = farHi;
+		}
+	}
+
+	static void searchKdTreeRadius( const Vec3 * points, const unsigned char * axes, const int * order, int lo, int hi, const Vec3 & q, double r2, std::vector< int > & result ){
+		while( lo < hi ){
+			int mid = lo + ( hi - lo ) / 2;
+			const Vec3 & p = points[ mid ];
+			double dx = q[ 0 ] - p[ 0 ];
+			double dy = q[ 1 ] - p[ 1 ];
+			double dz = q[ 2 ] - p[ 2 ];
+			if( dx * dx + dy * dy + dz * dz <= r2 ){
+				result.push_back( order[ mid ] );
+			}
+			int axis = axes[ mid ];
+			double diff = q[ axis ] - p[ axis ];
+			if( diff * diff <= r2 ){
+				searchKdTreeRadius( points, axes, order, diff < 0.0 ? mid + 1 : lo, diff < 0.0 ? hi : mid, q, r2, result );
+			}
+			lo = diff < 0.0 ? lo : mid + 1;
+			hi = diff < 0.0 ? mid : hi;
+		}
+	}
+
+	KdTree::KdTree( void ){
+	}
+
+	KdTree::KdTree( const Vec3 * points, int count ){
+		build( points, count );
+	}
+
+	void KdTree::build( const Vec3 * points, int count ){
+		m_indices.resize( count );
+		m_axes.resize( count );
+		m_points.resize( count );
+		if( count == 0 ){
+			return;
+		}
+		for( int i = 0; i < count; i++ ){
+			m_indices[ i ] = i;
+		}
+		MU_PRAGMA( omp parallel if( count > MU_PARALLEL_GRAIN ) )
+		MU_PRAGMA( omp single )
+		buildKdTree( points, & m_indices[ 0 ], & m_axes[ 0 ], 0, count );
+
+		// copy the points into tree order so that traversal reads them sequentially
+		MU_PARALLEL_FOR
+		for( int i = 0; i < count; i++ ){
+			m_points[ i ] = points[ m_indices[ i ] ];
+		}
+	}
+
+	int KdTree::size( void ) const {
+		return( ( int )m_points.size() );
+	}
+
+	int KdTree::nearest( const Vec3 & query, double * distance2 ) const {
+		int index;
+		double d2;
+		if( nearest( query, 1, & index, & d2 ) == 0 ){
+			return( -1 );
+		}
+		if( distance2 ){
+			* distance2 = d2;
+		}
+		return( index );
+	}
+
+	int KdTree::nearest( const Vec3 & query, int k, int * indices, double * distances2 ) const {
+		int count = 0;
+		if( ! m_points.empty() && k > 0 ){
+			searchKdTree( & m_points[ 0 ], & m_axes[ 0 ], 0, size(), query, k, indices, distances2, count );
+			heapSort( indices, distances2, count );
+		}
+		for( int i = 0; i < count; i++ ){
+			indices[ i ] = m_indices[ indices[ i ] ];
+		}
+		for( int i = count; i < k; i++ ){
+			indices[ i ] = -1;
+			distances2[ i ] = HUGE_VAL;
+		}
+		return( count );
+	}
+
+	int KdTree::radius( const Vec3 & query, double radius, std::vector< int > & indices ) const {
+		indices.clear();
+		if( ! m_points.empty() ){
+			searchKdTreeRadius( & m_points[ 0 ], & m_axes[ 0 ], & m_indices[ 0 ], 0, size(), query, radius * radius, indices );
+		}
+		return( ( int )indices.size() );
+	}
+
+	void KdTree::nearest( const Vec3 * queries, int queryCount, int k, int * indices, double * distances2 ) const {
+		MU_PRAGMA( omp parallel for schedule( dynamic, 256 ) )
+		for( int i = 0; i < queryCount; i++ ){
+			nearest( queries[ i ], k, indices + ( size_t )i * k, distances2 + ( size_t )i * k );
+		}
+	}
+
+	void KdTree::radius( const Vec3 * queries, int queryCount, double r, std::vector< std::vector< int > > & indices ) const {
+		indices.resize( queryCount );
+		MU_PRAGMA( omp parallel for schedule( dynamic, 256 ) )
+		for( int i = 0; i < queryCount; i++ ){
+			radius( queries[ i ], r, indices[ i ] );
+		}
+	}
+
+	///--------------------------------SpatialHashGrid--------------------
+
+	/// exclusive prefix sum, one block per thread
+	static void exclusiveScan( unsigned int * values, int count ){
+#if defined( _OPENMP )
+		std::vector< unsigned int > partial( omp_get_max_threads() + 1, 0 );
+		MU_PRAGMA( omp parallel if( count > MU_PARALLEL_GRAIN ) )
+		{
+			int threads = omp_get_num_threads();
+			int thread = omp_get_thread_num();
+			int lo = ( int )( ( long long )count * thread / threads );
+			int hi = ( int )( ( long long )count * ( thread + 1 ) / threads );
+			unsigned int sum = 0;
+			for( int i = lo; i < hi; i++ ){
+				sum += values[ i ];
+			}
+			partial[ thread + 1 ] = sum;
+			MU_PRAGMA( omp barrier )
+			MU_PRAGMA( omp single )
+			for( int t = 1; t <= threads; t++ ){
+				partial[ t ] += partial[ t - 1 ];
+			}
+			sum = partial[ thread ];
+			for( int i = lo; i < hi; i++ ){
+				unsigned int v = values[ i ];
+				values[ i ] = sum;
+				sum += v;
+			}
+		}
+#else
+		unsigned int sum = 0;
+		for( int i = 0; i < count; i++ ){
+			unsigned int v = values[ i ];
+			values[ i ] = sum;
+			sum += v;
+		}
+#endif
+	}
+
+	static unsigned int cellHash( int x, int y, int z ){
+		return( ( ( unsigned int )x * 73856093u ) ^ ( ( unsigned int )y * 19349663u ) ^ ( ( unsigned int )z * 83492791u ) );
+	}
+
+	SpatialHashGrid::SpatialHashGrid( double cellSize ) :
+		m_mask( 0 ){
+		setCellSize( cellSize );
+	}
+
+	void SpatialHashGrid::setCellSize( double cellSize ){
+		m_cellSize = cellSize;
+		m_inverseCellSize = 1.0 / cellSize;
+	}
+
+	double SpatialHashGrid::getCellSize( void ) const {
+		return( m_cellSize );
+	}
+
+	int SpatialHashGrid::size( void ) const {
+		return( ( int )m_points.size() );
+	}
+
+	unsigned int SpatialHashGrid::bucket( const Vec3 & p ) const {
+		return( cellHash(	( int )floor( p[ 0 ] * m_inverseCellSize ),
+							( int )floor( p[ 1 ] * m_inverseCellSize ),
+							( int )floor( p[ 2 ] * m_inverseCellSize ) ) & m_mask );
+	}
+
+	void SpatialHashGrid::rebuild( const Vec3 * points, int count, int tableSize ){
+		// the table is a power of two, by default about twice the number of points
+		unsigned int buckets = 1;
+		unsigned int wanted = tableSize > 0 ? ( unsigned int )tableSize : 2u * ( unsigned int )count;
+		while( buckets < wanted ){
+			buckets <<= 1;
+		}
+		m_mask = buckets - 1;
+		m_bucketStart.assign( buckets + 1, 0 );
+		m_indices.resize( count );
+		m_points.resize( count );
+
+		std::vector< unsigned int > keys( count );
+		unsigned int * start = & m_bucketStart[ 0 ];
+
+		// histogram, the increments are atomic so no thread ever waits on a lock
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			unsigned int key = bucket( points[ i ] );
+			keys[ i ] = key;
+			MU_PRAGMA( omp atomic )
+			start[ key ]++;
+		}
+
+		exclusiveScan( start, ( int )buckets + 1 );
+
+		// scatter through per bucket cursors, claimed atomically
+		std::vector< unsigned int > cursor( m_bucketStart.begin(), m_bucketStart.end() - 1 );
+		unsigned int * next = & cursor[ 0 ];
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			unsigned int slot;
+			MU_PRAGMA( omp atomic capture )
+			slot = next[ keys[ i ] ]++;
+			m_indices[ slot ] = i;
+			m_points[ slot ] = points[ i ];
+		}
+	}
+
+	/// unique buckets covering the cells within radius of the query
+	void SpatialHashGrid::gatherBuckets( const Vec3 & q, double radius, std::vector< unsigned int > & buckets ) const {
+		buckets.clear();
+		int lo[ 3 ], hi[ 3 ];
+		double cells = 1.0;
+		for( int i = 0; i < 3; i++ ){
+			lo[ i ] = ( int )floor( ( q[ i ] - radius ) * m_inverseCellSize );
+			hi[ i ] = ( int )floor( ( q[ i ] + radius ) * m_inverseCellSize );
+			cells *= ( double )( hi[ i ] - lo[ i ] + 1 );
+		}
+		if( cells > ( double )m_mask ){
+			// the query covers more cells than there are buckets, visit them all
+			for( unsigned int b = 0; b <= m_mask; b++ ){
+				buckets.push_back( b );
+			}
+			return;
+		}
+		for( int z = lo[ 2 ]; z <= hi[ 2 ]; z++ ){
+			for( int y = lo[ 1 ]; y <= hi[ 1 ]; y++ ){
+				for( int x = lo[ 0 ]; x <= hi[ 0 ]; x++ ){
+					buckets.push_back( cellHash( x, y, z ) & m_mask );
+				}
+			}
+		}
+		// distinct cells may share a bucket, visit each bucket once
+		std::sort( buckets.begin(), buckets.end() );
+		buckets.erase( std::unique( buckets.begin(), buckets.end() ), buckets.end() );
+	}
+
+	int SpatialHashGrid::neighbours( const Vec3 & query, double radius, std::vector< int > & indices ) const {
+		indices.clear();
+		if( m_points.empty() ){
+			return( 0 );
+		}
+		std::vector< unsigned int > buckets;
+		gatherBuckets( query, radius, buckets );
+		double r2 = radius * radius;
+		for( size_t b = 0; b < buckets.size(); b++ ){
+			unsigned int end = m_bucketStart[ buckets[ b ] + 1 ];
+			for( unsigned int i = m_bucketStart[ buckets[ b ] ]; i < end; i++ ){
+				const Vec3 & p = m_points[ i ];
+				double dx = p[ 0 ] - query[ 0 ];
+				double dy = p[ 1 ] - query[ 1 ];
+				double dz = p[ 2 ] - query[ 2 ];
+				if( dx * dx + dy * dy + dz * dz <= r2 ){
+					indices.push_back( m_indices[ i ] );
+				}
+			}
+		}
+		return( ( int )indices.size() );
+	}
+
+	/// neighbours of every point, as compressed rows: the neighbours of point i are
+	/// indices[ offsets[ i ] ] .. indices[ offsets[ i + 1 ] - 1 ], the point itself included
+	void SpatialHashGrid::neighbours( double radius, std::vector< int > & offsets, std::vector< int > & indices ) const {
+		int count = size();
+		offsets.assign( count + 1, 0 );
+		double r2 = radius * radius;
+
+		// two passes over the same traversal, count then fill, so that the rows can be
+		// written in parallel into one preallocated array
+		for( int pass = 0; pass < 2; pass++ ){
+			MU_PRAGMA( omp parallel if( count > MU_PARALLEL_GRAIN ) )
+			{
+				std::vector< unsigned int > buckets;
+				MU_PRAGMA( omp for schedule( dynamic, 1024 ) )
+				for( int s = 0; s < count; s++ ){
+					const Vec3 & q = m_points[ s ];
+					int self = m_indices[ s ];
+					int n = 0;
+					int * row = pass && ! indices.empty() ? & indices[ 0 ] + offsets[ self ] : 0;
+					gatherBuckets( q, radius, buckets );
+					for( size_t b = 0; b < buckets.size(); b++ ){
+						unsigned int end = m_bucketStart[ buckets[ b ] + 1 ];
+						for( unsigned int i = m_bucketStart[ buckets[ b ] ]; i < end; i++ ){
+							const Vec3 & p = m_points[ i ];
+							double dx = p[ 0 ] - q[ 0 ];
+							double dy = p[ 1 ] - q[ 1 ];
+							double dz = p[ 2 ] - q[ 2 ];
+							if( dx * dx + dy * dy + dz * dz <= r2 ){
+								if( pass ){
+									row[ n ] = m_indices[ i ];
+								}
+								n++;
+							}
+						}
+					}
+					if( ! pass ){
+						offsets[ self ] = n;
+					}
+				}
+			}
+			if( ! pass ){
+				exclusiveScan( ( unsigned int * )& offsets[ 0 ], count + 1 );
+				indices.resize( offsets[ count ] );
+			}
+		}
+	}
+
+	///--------------------------------registration-----------------------
+
+	/// one streaming pass over the correspondences. Points are shifted by the first pair so
+	/// that the raw second moments do not cancel catastrophically for data far from the origin.
+	static double registerPoints( const Vec3 * source, const Vec3 * target, int count, const double * weights, Mat3 & rotation, Vec3 & translation, double & scale, bool withScale ){
+		rotation = Mat3();
+		translation = Vec3( 0.0 );
+		scale = 1.0;
+		if( count <= 0 ){
+			return( 0.0 );
+		}
+		const Vec3 s0 = source[ 0 ];
+		const Vec3 t0 = target[ 0 ];
+		double w = 0.0, sx = 0.0, sy = 0.0, sz = 0.0, tx = 0.0, ty = 0.0, tz = 0.0, ss = 0.0, tt = 0.0;
+		double h00 = 0.0, h01 = 0.0, h02 = 0.0, h10 = 0.0, h11 = 0.0, h12 = 0.0, h20 = 0.0, h21 = 0.0, h22 = 0.0;
+		MU_PRAGMA( omp parallel for schedule( static ) reduction( + : w, sx, sy, sz, tx, ty, tz, ss, tt, h00, h01, h02, h10, h11, h12, h20, h21, h22 ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			double wi = weights ? weights[ i ] : 1.0;
+			double ax = source[ i ][ 0 ] - s0[ 0 ], ay = source[ i ][ 1 ] - s0[ 1 ], az = source[ i ][ 2 ] - s0[ 2 ];
+			double bx = target[ i ][ 0 ] - t0[ 0 ], by = target[ i ][ 1 ] - t0[ 1 ], bz = target[ i ][ 2 ] - t0[ 2 ];
+			double wax = wi * ax, way = wi * ay, waz = wi * az;
+			w += wi;
+			sx += wax;
+			sy += way;
+			sz += waz;
+			tx += wi * bx;
+			ty += wi * by;
+			tz += wi * bz;
+			ss += wax * ax + way * ay + waz * az;
+			tt += wi * ( bx * bx + by * by + bz * bz );
+			h00 += wax * bx;
+			h01 += wax * by;
+			h02 += wax * bz;
+			h10 += way * bx;
+			h11 += way * by;
+			h12 += way * bz;
+			h20 += waz * bx;
+			h21 += waz * by;
+			h22 += waz * bz;
+		}
+		if( w <= 0.0 ){
+			return( 0.0 );
+		}
+		Vec3 cs( sx / w, sy / w, sz / w );
+		Vec3 ct( tx / w, ty / w, tz / w );
+		// cross covariance H = sum( ( s - cs ) ( t - ct )^T ) / w, element ( row i, column j )
+		Mat3 h = Mat3::fromRowMajor(	h00 / w - cs[ 0 ] * ct[ 0 ], h01 / w - cs[ 0 ] * ct[ 1 ], h02 / w - cs[ 0 ] * ct[ 2 ],
+										h10 / w - cs[ 1 ] * ct[ 0 ], h11 / w - cs[ 1 ] * ct[ 1 ], h12 / w - cs[ 1 ] * ct[ 2 ],
+										h20 / w - cs[ 2 ] * ct[ 0 ], h21 / w - cs[ 2 ] * ct[ 1 ], h22 / w - cs[ 2 ] * ct[ 2 ] );
+		double varSource = ss / w - cs.hyp();
+		double varTarget = tt / w - ct.hyp();
+
+		// the svd keeps u and v rotations, so v * u^T already is the best proper rotation
+		// and the signed singular values sum to trace( D * E ) of Umeyama's paper
+		Mat3 u, v;
+		Vec3 sigma;
+		h.svd( u, sigma, v );
+		rotation = v * u.transpose();
+		double traceDE = sigma[ 0 ] + sigma[ 1 ] + sigma[ 2 ];
+		double error2;
+		if( withScale && varSource > 0.0 ){
+			scale = traceDE / varSource;
+			error2 = varTarget - traceDE * scale;
+		}
+		else{
+			error2 = varSource + varTarget - 2.0 * traceDE;
+		}
+		translation = ( ct + t0 ) - rotation * ( cs + s0 ) * scale;
+		return( error2 > 0.0 ? sqrt( error2 ) : 0.0 );
+	}
+
+	Mat4 registerPoints( const Vec3 * source, const Vec3 * target, int count, bool withScale, const double * weights ){
+		Mat3 rotation;
+		Vec3 translation;
+		double scale;
+		registerPoints( source, target, count, weights, rotation, translation, scale, withScale );
+		return( Mat4::fromTransformation( translation, rotation, Vec3( scale ) ) );
+	}
+
+	double registerPoints( const Vec3 * source, const Vec3 * target, int count, Quat & rotation, Vec3 & translation, double & scale, bool withScale, const double * weights ){
+		Mat3 r;
+		double rms = registerPoints( source, target, count, weights, r, translation, scale, withScale );
+		rotation = Quat::fromMat3( r );
+		rotation.normalize();
+		return( rms );
+	}
+
+	///--------------------------------space filling curves---------------
+
+	static int maxThreads( void ){
+#if defined( _OPENMP )
+		return( omp_get_max_threads() );
+#else
+		return( 1 );
+#endif
+	}
+
+#if ! defined( __BMI2__ )
+	static uint64_t spreadBits( unsigned int v ){
+		uint64_t x = v & 0x1fffff;
+		x = ( x | x << 32 ) & 0x1f00000000ffffULL;
+		x = ( x | x << 16 ) & 0x1f0000ff0000ffULL;
+		x = ( x | x << 8 ) & 0x100f00f00f00f00fULL;
+		x = ( x | x << 4 ) & 0x10c30c30c30c30c3ULL;
+		x = ( x | x << 2 ) & 0x1249249249249249ULL;
+		return( x );
+	}
+
+	static unsigned int compactBits( uint64_t x ){
+		x &= 0x1249249249249249ULL;
+		x = ( x ^ ( x >> 2 ) ) & 0x10c30c30c30c30c3ULL;
+		x = ( x ^ ( x >> 4 ) ) & 0x100f00f00f00f00fULL;
+		x = ( x ^ ( x >> 8 ) ) & 0x1f0000ff0000ffULL;
+		x = ( x ^ ( x >> 16 ) ) & 0x1f00000000ffffULL;
+		x = ( x ^ ( x >> 32 ) ) & 0x1fffff;
+		return( ( unsigned int )x );
+	}
+#endif
+
+	uint64_t mortonEncode( unsigned int x, unsigned int y, unsigned int z ){
+#if defined( __BMI2__ )
+		return( _pdep_u64( x, 0x1249249249249249ULL ) | _pdep_u64( y, 0x2492492492492492ULL ) | _pdep_u64( z, 0x4924924924924924ULL ) );
+#else
+		return( spreadBits( x ) | spreadBits( y ) << 1 | spreadBits( z ) << 2 );
+#endif
+	}
+
+	void mortonDecode( uint64_t code, unsigned int & x, unsigned int & y, unsigned int & z ){
+#if defined( __BMI2__ )
+		x = ( unsigned int )_pext_u64( code, 0x1249249249249249ULL );
+		y = ( unsigned int )_pext_u64( code, 0x2492492492492492ULL );
+		z = ( unsigned int )_pext_u64( code, 0x4924924924924924ULL );
+#else
+		x = compactBits( code );
+		y = compactBits( code >> 1 );
+		z = compactBits( code >> 2 );
+#endif
+	}
+
+	/// Hilbert curve through the transposed index of J. Skilling, "Programming the Hilbert
+	/// curve", AIP Conf. Proc. 707, 2004: the index interleaves the transposed coordinates
+	/// with the first one in the most significant bit of each triple
+	uint64_t hilbertEncode( unsigned int x, unsigned int y, unsigned int z ){
+		unsigned int X[ 3 ] = { x & 0x1fffff, y & 0x1fffff, z & 0x1fffff };
+		unsigned int t;
+		for( unsigned int q = 1u << 20; q > 1; q >>= 1 ){
+			unsigned int p = q - 1;
+			for( int i = 0; i < 3; i++ ){
+				if( X[ i ] & q ){
+					X[ 0 ] ^= p;
+				}
+				else{
+					t = ( X[ 0 ] ^ X[ i ] ) & p;
+					X[ 0 ] ^= t;
+					X[ i ] ^= t;
+				}
+			}
+		}
+		X[ 1 ] ^= X[ 0 ];
+		X[ 2 ] ^= X[ 1 ];
+		t = 0;
+		for( unsigned int q = 1u << 20; q > 1; q >>= 1 ){
+			if( X[ 2 ] & q ){
+				t ^= q - 1;
+			}
+		}
+		X[ 0 ] ^= t;
+		X[ 1 ] ^= t;
+		X[ 2 ] ^= t;
+		return( mortonEncode( X[ 2 ], X[ 1 ], X[ 0 ] ) );
+	}
+
+	void hilbertDecode( uint64_t code, unsigned int & x, unsigned int & y, unsigned int & z ){
+		unsigned int X[ 3 ];
+		mortonDecode( code, X[ 2 ], X[ 1 ], X[ 0 ] );
+		unsigned int t = X[ 2 ] >> 1;
+		X[ 2 ] ^= X[ 1 ];
+		X[ 1 ] ^= X[ 0 ];
+		X[ 0 ] ^= t;
+		for( unsigned int q = 2; q != 1u << 21; q <<= 1 ){
+			unsigned int p = q - 1;
+			for( int i = 2; i >= 0; i-- ){
+				if( X[ i ] & q ){
+					X[ 0 ] ^= p;
+				}
+				else{
+					t = ( X[ 0 ] ^ X[ i ] ) & p;
+					X[ 0 ] ^= t;
+					X[ i ] ^= t;
+				}
+			}
+		}
+		x = X[ 0 ];
+		y = X[ 1 ];
+		z = X[ 2 ];
+	}
+
+	static void quantizeGrid( const Vec3 & boxMin, const Vec3 & boxMax, double * scale ){
+		for( int i = 0; i < 3; i++ ){
+			double extent = boxMax[ i ] - boxMin[ i ];
+			scale[ i ] = extent > 0.0 ? 2097152.0 / extent : 0.0;
+		}
+	}
+
+	static unsigned int quantize( double v, double lo, double scale ){
+		double q = ( v - lo ) * scale;
+		return( q <= 0.0 ? 0u : q >= 2097151.0 ? 2097151u : ( unsigned int )q );
+	}
+
+	static void encodeCurve( const Vec3 * points, int count, const Vec3 & boxMin, const Vec3 & boxMax, uint64_t * codes, bool hilbert ){
+		double scale[ 3 ];
+		quantizeGrid( boxMin, boxMax, scale );
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			unsigned int x = quantize( points[ i ][ 0 ], boxMin[ 0 ], scale[ 0 ] );
+			unsigned int y = quantize( points[ i ][ 1 ], boxMin[ 1 ], scale[ 1 ] );
+			unsigned int z = quantize( points[ i ][ 2 ], boxMin[ 2 ], scale[ 2 ] );
+			codes[ i ] = hilbert ? hilbertEncode( x, y, z ) : mortonEncode( x, y, z );
+		}
+	}
+
+	static void decodeCurve( const uint64_t * codes, int count, const Vec3 & boxMin, const Vec3 & boxMax, Vec3 * points, bool hilbert ){
+		Vec3 cell = ( boxMax - boxMin ) / 2097152.0;
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			unsigned int x, y, z;
+			if( hilbert ){
+				hilbertDecode( codes[ i ], x, y, z );
+			}
+			else{
+				mortonDecode( codes[ i ], x, y, z );
+			}
+			points[ i ] = Vec3(	boxMin[ 0 ] + ( x + 0.5 ) * cell[ 0 ],
+								boxMin[ 1 ] + ( y + 0.5 ) * cell[ 1 ],
+								boxMin[ 2 ] + ( z + 0.5 ) * cell[ 2 ] );
+		}
+	}
+
+	void mortonEncode( const Vec3 * points, int count, const Vec3 & boxMin, const Vec3 & boxMax, uint64_t * codes ){
+		encodeCurve( points, count, boxMin, boxMax, codes, false );
+	}
+
+	void mortonDecode( const uint64_t * codes, int count, const Vec3 & boxMin, const Vec3 & boxMax, Vec3 * points ){
+		decodeCurve( codes, count, boxMin, boxMax, points, false );
+	}
+
+	void hilbertEncode( const Vec3 * points, int count, const Vec3 & boxMin, const Vec3 & boxMax, uint64_t * codes ){
+		encodeCurve( points, count, boxMin, boxMax, codes, true );
+	}
+
+	void hilbertDecode( const uint64_t * codes, int count, const Vec3 & boxMin, const Vec3 & boxMax, Vec3 * points ){
+		decodeCurve( codes, count, boxMin, boxMax, points, true );
+	}
+
+	/// LSD radix sort of ( key, index ) pairs on 8 bit digits. Every thread histograms and
+	/// scatters its own contiguous chunk, the offsets are laid out digit by digit and thread
+	/// by thread which keeps the sort stable. Passes over a digit all keys share are skipped.
+	static void radixSortPairs( uint64_t * keys, int * values, int count ){
+		int threads = count > MU_PARALLEL_GRAIN ? maxThreads() : 1;
+		std::vector< uint64_t > keyBuffer( count );
+		std::vector< int > valueBuffer( count );
+		std::vector< int > histogram( threads * 256 );
+		uint64_t * srcKeys = keys;
+		uint64_t * dstKeys = count ? & keyBuffer[ 0 ] : 0;
+		int * srcValues = values;
+		int * dstValues = count ? & valueBuffer[ 0 ] : 0;
+
+		for( int shift = 0; shift < 64; shift += 8 ){
+			MU_PRAGMA( omp parallel for schedule( static, 1 ) num_threads( threads ) )
+			for( int t = 0; t < threads; t++ ){
+				int * h = & histogram[ t * 256 ];
+				int lo = ( int )( ( long long )count * t / threads );
+				int hi = ( int )( ( long long )count * ( t + 1 ) / threads );
+				memset( h, 0, 256 * sizeof( int ) );
+				for( int i = lo; i < hi; i++ ){
+					h[ ( srcKeys[ i ] >> shift ) & 0xff ]++;
+				}
+			}
+
+			bool trivial = false;
+			int offset = 0;
+			for( int d = 0; d < 256; d++ ){
+				int total = 0;
+				for( int t = 0; t < threads; t++ ){
+					int n = histogram[ t * 256 + d ];
+					histogram[ t * 256 + d ] = offset;
+					offset += n;
+					total += n;
+				}
+				trivial = trivial || total == count;
+			}
+			if( trivial ){
+				continue;
+			}
+
+			MU_PRAGMA( omp parallel for schedule( static, 1 ) num_threads( threads ) )
+			for( int t = 0; t < threads; t++ ){
+				int * h = & histogram[ t * 256 ];
+				int lo = ( int )( ( long long )count * t / threads );
+				int hi = ( int )( ( long long )count * ( t + 1 ) / threads );
+				for( int i = lo; i < hi; i++ ){
+					int slot = h[ ( srcKeys[ i ] >> shift ) & 0xff ]++;
+					dstKeys[ slot ] = srcKeys[ i ];
+					dstValues[ slot ] = srcValues[ i ];
+				}
+			}
+			std::swap( srcKeys, dstKeys );
+			std::swap( srcValues, dstValues );
+		}
+		if( srcKeys != keys ){
+			memcpy( keys, srcKeys, count * sizeof( uint64_t ) );
+			memcpy( values, srcValues, count * sizeof( int ) );
+		}
+	}
+
+	void radixSort( const uint64_t * keys, int count, int * permutation ){
+		std::vector< uint64_t > sorted( keys, keys + count );
+		for( int i = 0; i < count; i++ ){
+			permutation[ i ] = i;
+		}
+		if( count > 1 ){
+			radixSortPairs( & sorted[ 0 ], permutation, count );
+		}
+	}
+
+	/// map IEEE bits to unsigned keys of the same order, negative values have all bits flipped
+	static uint64_t sortableKey( double v ){
+		uint64_t bits;
+		memcpy( & bits, & v, sizeof( bits ) );
+		return( bits & 0x8000000000000000ULL ? ~bits : bits | 0x8000000000000000ULL );
+	}
+
+	static uint64_t sortableKey( float v ){
+		uint32_t bits;
+		memcpy( & bits, & v, sizeof( bits ) );
+		return( bits & 0x80000000u ? ~bits : bits | 0x80000000u );
+	}
+
+	template< class T >
+	static void radixSortFloating( const T * keys, int count, int * permutation ){
+		std::vector< uint64_t > sortable( count );
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			sortable[ i ] = sortableKey( keys[ i ] );
+			permutation[ i ] = i;
+		}
+		if( count > 1 ){
+			radixSortPairs( & sortable[ 0 ], permutation, count );
+		}
+	}
+
+	void radixSort( const double * keys, int count, int * permutation ){
+		radixSortFloating( keys, count, permutation );
+	}
+
+	void radixSort( const float * keys, int count, int * permutation ){
+		// float keys only occupy the low 32 bits, the upper passes are skipped
+		radixSortFloating( keys, count, permutation );
+	}
+
+	void sortByDepth( const Vec3 * points, int count, const Mat4 & modelView, int * permutation, bool backToFront ){
+		// only the z row of the transform is needed
+		const double m2 = modelView[ 2 ], m6 = modelView[ 6 ], m10 = modelView[ 10 ], m14 = modelView[ 14 ];
+		std::vector< uint64_t > keys( count );
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			const Vec3 & p = points[ i ];
+			uint64_t key = sortableKey( m2 * p[ 0 ] + m6 * p[ 1 ] + m10 * p[ 2 ] + m14 );
+			keys[ i ] = backToFront ? key : ~key;
+			permutation[ i ] = i;
+		}
+		if( count > 1 ){
+			radixSortPairs( & keys[ 0 ], permutation, count );
+		}
+	}
+
+	void spatialOrder( const Vec3 * points, int count, int * permutation, bool hilbert ){
+		if( count <= 0 ){
+			return;
+		}
+		double x0 = points[ 0 ][ 0 ], y0 = points[ 0 ][ 1 ], z0 = points[ 0 ][ 2 ];
+		double x1 = x0, y1 = y0, z1 = z0;
+		MU_PRAGMA( omp parallel for schedule( static ) reduction( min : x0, y0, z0 ) reduction( max : x1, y1, z1 ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			const Vec3 & p = points[ i ];
+			x0 = p[ 0 ] < x0 ? p[ 0 ] : x0;
+			y0 = p[ 1 ] < y0 ? p[ 1 ] : y0;
+			z0 = p[ 2 ] < z0 ? p[ 2 ] : z0;
+			x1 = p[ 0 ] > x1 ? p[ 0 ] : x1;
+			y1 = p[ 1 ] > y1 ? p[ 1 ] : y1;
+			z1 = p[ 2 ] > z1 ? p[ 2 ] : z1;
+		}
+		std::vector< uint64_t > codes( count );
+		encodeCurve( points, count, Vec3( x0, y0, z0 ), Vec3( x1, y1, z1 ), & codes[ 0 ], hilbert );
+		for( int i = 0; i < count; i++ ){
+			permutation[ i ] = i;
+		}
+		radixSortPairs( & codes[ 0 ], permutation, count );
+	}
+
+	/// data[ i ] = old data[ permutation[ i ] ] for elements of any trivially copyable type
+	void permute( void * data, int elementSize, const int * permutation, int count ){
+		std::vector< char > copy( ( const char * )data, ( const char * )data + ( size_t )count * elementSize );
+		char * dst = ( char * )data;
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			memcpy( dst + ( size_t )i * elementSize, & copy[ 0 ] + ( size_t )permutation[ i ] * elementSize, elementSize );
+		}
+	}
+
+	///--------------------------------Icp--------------------------------
+
+	static double wallTime( void ){
+#if defined( _OPENMP )
+		return( omp_get_wtime() );
+#else
+		return( ( double )clock() / CLOCKS_PER_SEC );
+#endif
+	}
+
+	/// Cholesky solve of a symmetric positive definite 6x6 system, false when it is singular
+	static bool solveSymmetric6( double a[ 6 ][ 6 ], const double * b, double * x ){
+		for( int j = 0; j < 6; j++ ){
+			double d = a[ j ][ j ];
+			for( int k = 0; k < j; k++ ){
+				d -= a[ j ][ k ] * a[ j ][ k ];
+			}
+			if( d <= DBL_MIN ){
+				return( false );
+			}
+			a[ j ][ j ] = sqrt( d );
+			for( int i = j + 1; i < 6; i++ ){
+				double v = a[ i ][ j ];
+				for( int k = 0; k < j; k++ ){
+					v -= a[ i ][ k ] * a[ j ][ k ];
+				}
+				a[ i ][ j ] = v / a[ j ][ j ];
+			}
+		}
+		for( int i = 0; i < 6; i++ ){
+			double v = b[ i ];
+			for( int k = 0; k < i; k++ ){
+				v -= a[ i ][ k ] * x[ k ];
+			}
+			x[ i ] = v / a[ i ][ i ];
+		}
+		for( int i = 5; i >= 0; i-- ){
+			double v = x[ i ];
+			for( int k = i + 1; k < 6; k++ ){
+				v -= a[ k ][ i ] * x[ k ];
+			}
+			x[ i ] = v / a[ i ][ i ];
+		}
+		return( true );
+	}
+
+	/// rotation by the vector omega, |omega| radians about its direction
+	static Mat3 rotationFromVector( const Vec3 & omega ){
+		double angle = sqrt( omega.hyp() );
+		if( angle < DBL_EPSILON ){
+			return( Mat3() );
+		}
+		Vec3 k = omega / angle;
+		double c = cos( angle );
+		double s = sin( angle );
+		double c1 = 1.0 - c;
+		return( Mat3(	c + k[ 0 ] * k[ 0 ] * c1, k[ 1 ] * k[ 0 ] * c1 + k[ 2 ] * s, k[ 2 ] * k[ 0 ] * c1 - k[ 1 ] * s,
+						k[ 0 ] * k[ 1 ] * c1 - k[ 2 ] * s, c + k[ 1 ] * k[ 1 ] * c1, k[ 2 ] * k[ 1 ] * c1 + k[ 0 ] * s,
+						k[ 0 ] * k[ 2 ] * c1 + k[ 1 ] * s, k[ 1 ] * k[ 2 ] * c1 - k[ 0 ] * s, c + k[ 2 ] * k[ 2 ] * c1 ) );
+	}
+
+	/// one Gauss-Newton step of sum( ( ( p + omega x p + t ) - q ) . n )^2, accumulated in
+	/// one chunk per thread and summed afterwards
+	static bool pointToPlaneStep( const Vec3 * p, const Vec3 * q, const Vec3 * n, int count, Mat4 & delta ){
+		int chunks = count > MU_PARALLEL_GRAIN ? maxThreads() : 1;
+		std::vector< double > partial( chunks * 27, 0.0 );
+		MU_PRAGMA( omp parallel for schedule( static, 1 ) num_threads( chunks ) )
+		for( int c = 0; c < chunks; c++ ){
+			double * sum = & partial[ c * 27 ];
+			int lo = ( int )( ( long long )count * c / chunks );
+			int hi = ( int )( ( long long )count * ( c + 1 ) / chunks );
+			for( int i = lo; i < hi; i++ ){
+				Vec3 pn = p[ i ].cross( n[ i ] );
+				double j[ 6 ] = { pn[ 0 ], pn[ 1 ], pn[ 2 ], n[ i ][ 0 ], n[ i ][ 1 ], n[ i ][ 2 ] };
+				double r = ( p[ i ] - q[ i ] ).dot( n[ i ] );
+				int e = 0;
+				for( int row = 0; row < 6; row++ ){
+					for( int col = 0; col <= row; col++ ){
+						sum[ e++ ] += j[ row ] * j[ col ];
+					}
+					sum[ 21 + row ] -= j[ row ] * r;
+				}
+			}
+		}
+		double a[ 6 ][ 6 ], b[ 6 ] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 }, x[ 6 ];
+		for( int row = 0, e = 0; row < 6; row++ ){
+			for( int col = 0; col <= row; col++, e++ ){
+				double v = 0.0;
+				for( int c = 0; c < chunks; c++ ){
+					v += partial[ c * 27 + e ];
+				}
+				a[ row ][ col ] = a[ col ][ row ] = v;
+			}
+			for( int c = 0; c < chunks; c++ ){
+				b[ row ] += partial[ c * 27 + 21 + row ];
+			}
+		}
+		if( ! solveSymmetric6( a, b, x ) ){
+			return( false );
+		}
+		delta = Mat4::fromTransformation( Vec3( x[ 3 ], x[ 4 ], x[ 5 ] ), rotationFromVector( Vec3( x[ 0 ], x[ 1 ], x[ 2 ] ) ) );
+		return( true );
+	}
+
+	Icp::Icp( void ) :
+		m_maxIterations( 50 ),
+		m_tolerance( 1e-6 ),
+		m_maxDistance( 0.0 ),
+		m_trimRatio( 0.0 ),
+		m_pointToPlane( false ),
+		m_converged( false ),
+		m_rmsError( 0.0 ){
+	}
+
+	void Icp::setMaxIterations( int iterations ){
+		m_maxIterations = iterations;
+	}
+
+	/// stop once the rms error improves by less than this fraction
+	void Icp::setTolerance( double relativeError ){
+		m_tolerance = relativeError;
+	}
+
+	/// pairs farther apart are rejected, 0.0 keeps all of them
+	void Icp::setMaxDistance( double distance ){
+		m_maxDistance = distance;
+	}
+
+	/// fraction of the remaining pairs with the largest distance to reject, in [ 0, 1 )
+	void Icp::setTrimRatio( double ratio ){
+		m_trimRatio = ratio;
+	}
+
+	/// needs target normals, without them point-to-point is used
+	void Icp::setPointToPlane( bool pointToPlane ){
+		m_pointToPlane = pointToPlane;
+	}
+
+	bool Icp::converged( void ) const {
+		return( m_converged );
+	}
+
+	double Icp::getRmsError( void ) const {
+		return( m_rmsError );
+	}
+
+	const std::vector< IcpIteration > & Icp::getIterations( void ) const {
+		return( m_iterations );
+	}
+
+	Mat4 Icp::align( const Vec3 * source, int sourceCount, const Vec3 * target, const Vec3 * targetNormals, int targetCount, const Mat4 & initial ){
+		KdTree tree( target, targetCount );
+		return( align( source, sourceCount, tree, target, targetNormals, initial ) );
+	}
+
+	Mat4 Icp::align( const Vec3 * source, int sourceCount, const KdTree & targetTree, const Vec3 * target, const Vec3 * targetNormals, const Mat4 & initial ){
+		Mat4 pose = initial;
+		bool planar = m_pointToPlane && targetNormals;
+		m_iterations.clear();
+		m_converged = false;
+		m_rmsError = 0.0;
+		if( sourceCount <= 0 || targetTree.size() <= 0 ){
+			return( pose );
+		}
+
+		// scratch for the whole run, nothing is allocated per iteration
+		std::vector< Vec3 > moved( sourceCount );
+		std::vector< int > match( sourceCount );
+		std::vector< double > distance2( sourceCount );
+		std::vector< double > sorted( sourceCount );
+		std::vector< Vec3 > p( sourceCount ), q( sourceCount ), n( planar ? sourceCount : 0 );
+		double maxDistance2 = m_maxDistance > 0.0 ? m_maxDistance * m_maxDistance : HUGE_VAL;
+		double previous = 0.0;
+		Mat4 bestPose = pose;
+		double bestError = HUGE_VAL;
+
+		// one more pass than updates, so that the pose of the last update is measured too
+		for( int iteration = 0; ; iteration++ ){
+			IcpIteration stats;
+			double start = wallTime();
+
+			// correspondences, Mat4 * Vec3 is safe to share between threads, unlike Mat4 * Mat4
+			// and *= which return through static scratch
+			MU_PRAGMA( omp parallel for schedule( dynamic, 256 ) )
+			for( int i = 0; i < sourceCount; i++ ){
+				moved[ i ] = pose * source[ i ];
+				match[ i ] = targetTree.nearest( moved[ i ], & distance2[ i ] );
+			}
+
+			// rejection, by distance then by rank among the pairs within the distance
+			double threshold = maxDistance2;
+			if( m_trimRatio > 0.0 ){
+				sorted.clear();
+				for( int i = 0; i < sourceCount; i++ ){
+					if( distance2[ i ] <= maxDistance2 ){
+						sorted.push_back( distance2[ i ] );
+					}
+				}
+				if( ! sorted.empty() ){
+					int keep = ( int )( ( 1.0 - m_trimRatio ) * sorted.size() );
+					keep = keep < 1 ? 1 : keep;
+					std::nth_element( sorted.begin(), sorted.begin() + ( keep - 1 ), sorted.end() );
+					threshold = sorted[ keep - 1 ];
+				}
+			}
+			int count = 0;
+			double error = 0.0;
+			for( int i = 0; i < sourceCount; i++ ){
+				if( distance2[ i ] > threshold ){
+					continue;
+				}
+				p[ count ] = moved[ i ];
+				q[ count ] = target[ match[ i ] ];
+				if( planar ){
+					n[ count ] = targetNormals[ match[ i ] ];
+					double d = ( p[ count ] - q[ count ] ).dot( n[ count ] );
+					error += d * d;
+				}
+				else{
+					error += distance2[ i ];
+				}
+				count++;
+			}
+			stats.correspondences = count;
+			stats.rmsError = count ? sqrt( error / count ) : 0.0;
+			stats.searchTime = wallTime() - start;
+			start = wallTime();
+			m_rmsError = stats.rmsError;
+
+			if( count < ( planar ? 6 : 3 ) ){
+				stats.solveTime = 0.0;
+				m_iterations.push_back( stats );
+				break;
+			}
+			if( stats.rmsError < bestError ){
+				bestError = stats.rmsError;
+				bestPose = pose;
+			}
+			if( stats.rmsError == 0.0 || ( iteration && previous - stats.rmsError <= m_tolerance * previous ) ){
+				// the last update did not pay off any more
+				stats.solveTime = 0.0;
+				m_iterations.push_back( stats );
+				m_converged = true;
+				break;
+			}
+			if( iteration >= m_maxIterations ){
+				stats.solveTime = 0.0;
+				m_iterations.push_back( stats );
+				break;
+			}
+			previous = stats.rmsError;
+
+			Mat4 delta;
+			if( planar ){
+				if( ! pointToPlaneStep( & p[ 0 ], & q[ 0 ], & n[ 0 ], count, delta ) ){
+					stats.solveTime = wallTime() - start;
+					m_iterations.push_back( stats );
+					break;
+				}
+			}
+			else{
+				delta = registerPoints( & p[ 0 ], & q[ 0 ], count );
+			}
+			pose = delta * pose;
+			stats.solveTime = wallTime() - start;
+			m_iterations.push_back( stats );
+		}
+		// every exit falls back to the best pose measured
+		if( bestError < HUGE_VAL ){
+			pose = bestPose;
+			m_rmsError = bestError;
+		}
+		return( pose );
+	}
+
+	///--------------------------------normals----------------------------
+
+	void estimateNormals( const Vec3 * points, int count, int k, const Vec3 & viewpoint, Vec3 * normals ){
+		KdTree tree( points, count );
+		estimateNormals( points, count, tree, k, viewpoint, normals );
+	}
+
+	void estimateNormals( const Vec3 * points, int count, const KdTree & tree, int k, const Vec3 & viewpoint, Vec3 * normals ){
+		if( count <= 0 || k <= 0 ){
+			return;
+		}
+		int chunks = count > MU_PARALLEL_GRAIN ? maxThreads() : 1;
+		// neighbour scratch of one chunk, reused for all of its points
+		std::vector< int > indices( ( size_t )chunks * k );
+		std::vector< double > distances2( ( size_t )chunks * k );
+		MU_PRAGMA( omp parallel for schedule( dynamic, 1 ) num_threads( chunks ) )
+		for( int c = 0; c < chunks; c++ ){
+			int * neighbours = & indices[ ( size_t )c * k ];
+			double * d2 = & distances2[ ( size_t )c * k ];
+			int lo = ( int )( ( long long )count * c / chunks );
+			int hi = ( int )( ( long long )count * ( c + 1 ) / chunks );
+			for( int i = lo; i < hi; i++ ){
+				int found = tree.nearest( points[ i ], k, neighbours, d2 );
+				if( found < 3 ){
+					normals[ i ] = Vec3( 0.0 );
+					continue;
+				}
+				Vec3 mean( 0.0 );
+				for( int j = 0; j < found; j++ ){
+					mean += points[ neighbours[ j ] ];
+				}
+				mean /= found;
+				double xx = 0.0, xy = 0.0, xz = 0.0, yy = 0.0, yz = 0.0, zz = 0.0;
+				for( int j = 0; j < found; j++ ){
+					Vec3 d = points[ neighbours[ j ] ] - mean;
+					xx += d[ 0 ] * d[ 0 ];
+					xy += d[ 0 ] * d[ 1 ];
+					xz += d[ 0 ] * d[ 2 ];
+					yy += d[ 1 ] * d[ 1 ];
+					yz += d[ 1 ] * d[ 2 ];
+					zz += d[ 2 ] * d[ 2 ];
+				}
+				Vec3 eigenvalues;
+				Mat3 eigenvectors;
+				Mat3( xx, xy, xz, xy, yy, yz, xz, yz, zz ).eigenSymmetric( eigenvalues, eigenvectors );
+				Vec3 normal = eigenvectors.getCol( 2 );
+				normals[ i ] = ( viewpoint - points[ i ] ).dot( normal ) < 0.0 ? -normal : normal;
+			}
+		}
+	}
+
+	///--------------------------------Obb--------------------------------
+
+	Obb::Obb( const Vec3 & center, const Mat3 & axes, const Vec3 & halfExtents ) :
+		m_center( center ),
+		m_axes( axes ),
+		m_halfExtents( halfExtents ){
+	}
+
+	Vec3 & Obb::center( void ){
+		return( m_center );
+	}
+
+	const Vec3 & Obb::center( void ) const {
+		return( m_center );
+	}
+
+	Mat3 & Obb::axes( void ){
+		return( m_axes );
+	}
+
+	const Mat3 & Obb::axes( void ) const {
+		return( m_axes );
+	}
+
+	Vec3 & Obb::halfExtents( void ){
+		return( m_halfExtents );
+	}
+
+	const Vec3 & Obb::halfExtents( void ) const {
+		return( m_halfExtents );
+	}
+
+	double Obb::volume( void ) const {
+		return( 8.0 * m_halfExtents[ 0 ] * m_halfExtents[ 1 ] * m_halfExtents[ 2 ] );
+	}
+
+	bool Obb::contains( const Vec3 & point ) const {
+		Vec3 d = point - m_center;
+		for( int i = 0; i < 3; i++ ){
+			if( fabs( d.dot( m_axes.getCol( i ) ) ) > m_halfExtents[ i ] ){
+				return( false );
+			}
+		}
+		return( true );
+	}
+
+	/// corner i lies on the positive side of axis j when bit j of i is set
+	void Obb::corners( Vec3 * eightCorners ) const {
+		Vec3 e[ 3 ];
+		for( int j = 0; j < 3; j++ ){
+			e[ j ] = m_axes.getCol( j ) * m_halfExtents[ j ];
+		}
+		for( int i = 0; i < 8; i++ ){
+			eightCorners[ i ] = m_center + ( i & 1 ? e[ 0 ] : -e[ 0 ] ) + ( i & 2 ? e[ 1 ] : -e[ 1 ] ) + ( i & 4 ? e[ 2 ] : -e[ 2 ] );
+		}
+	}
+
+	/// maps the [ -1, 1 ] cube onto the box
+	Mat4 Obb::toMat4( void ) const {
+		return( Mat4::fromTransformation( m_center, m_axes, m_halfExtents ) );
+	}
+
+	/// covariance of the points, one partial sum per chunk around the first point
+	static Mat3 pointCovariance( const Vec3 * points, int count, Vec3 & mean ){
+		int chunks = count > MU_PARALLEL_GRAIN ? maxThreads() : 1;
+		std::vector< double > partial( chunks * 9, 0.0 );
+		const Vec3 origin = points[ 0 ];
+		MU_PRAGMA( omp parallel for schedule( static, 1 ) num_threads( chunks ) )
+		for( int c = 0; c < chunks; c++ ){
+			double * sum = & partial[ c * 9 ];
+			int lo = ( int )( ( long long )count * c / chunks );
+			int hi = ( int )( ( long long )count * ( c + 1 ) / chunks );
+			for( int i = lo; i < hi; i++ ){
+				Vec3 d = points[ i ] - origin;
+				sum[ 0 ] += d[ 0 ];
+				sum[ 1 ] += d[ 1 ];
+				sum[ 2 ] += d[ 2 ];
+				sum[ 3 ] += d[ 0 ] * d[ 0 ];
+				sum[ 4 ] += d[ 0 ] * d[ 1 ];
+				sum[ 5 ] += d[ 0 ] * d[ 2 ];
+				sum[ 6 ] += d[ 1 ] * d[ 1 ];
+				sum[ 7 ] += d[ 1 ] * d[ 2 ];
+				sum[ 8 ] += d[ 2 ] * d[ 2 ];
+			}
+		}
+		double s[ 9 ] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		for( int c = 0; c < chunks; c++ ){
+			for( int j = 0; j < 9; j++ ){
+				s[ j ] += partial[ c * 9 + j ];
+			}
+		}
+		Vec3 m = Vec3( s[ 0 ], s[ 1 ], s[ 2 ] ) / count;
+		mean = origin + m;
+		double xx = s[ 3 ] / count - m[ 0 ] * m[ 0 ];
+		double xy = s[ 4 ] / count - m[ 0 ] * m[ 1 ];
+		double xz = s[ 5 ] / count - m[ 0 ] * m[ 2 ];
+		double yy = s[ 6 ] / count - m[ 1 ] * m[ 1 ];
+		double yz = s[ 7 ] / count - m[ 1 ] * m[ 2 ];
+		double zz = s[ 8 ] / count - m[ 2 ] * m[ 2 ];
+		return( Mat3( xx, xy, xz, xy, yy, yz, xz, yz, zz ) );
+	}
+
+	/// tight box around the points with the given axes
+	static Obb fitAxes( const Vec3 * points, int count, const Mat3 & axes ){
+		int chunks = count > MU_PARALLEL_GRAIN ? maxThreads() : 1;
+		std::vector< Vec3 > lo( chunks, Vec3( HUGE_VAL ) ), hi( chunks, Vec3( -HUGE_VAL ) );
+		Vec3 a0 = axes.getCol( 0 ), a1 = axes.getCol( 1 ), a2 = axes.getCol( 2 );
+		MU_PRAGMA( omp parallel for schedule( static, 1 ) num_threads( chunks ) )
+		for( int c = 0; c < chunks; c++ ){
+			int first = ( int )( ( long long )count * c / chunks );
+			int last = ( int )( ( long long )count * ( c + 1 ) / chunks );
+			Vec3 l = lo[ c ], h = hi[ c ];
+			for( int i = first; i < last; i++ ){
+				Vec3 d( a0.dot( points[ i ] ), a1.dot( points[ i ] ), a2.dot( points[ i ] ) );
+				for( int j = 0; j < 3; j++ ){
+					l[ j ] = d[ j ] < l[ j ] ? d[ j ] : l[ j ];
+					h[ j ] = d[ j ] > h[ j ] ? d[ j ] : h[ j ];
+				}
+			}
+			lo[ c ] = l;
+			hi[ c ] = h;
+		}
+		for( int c = 1; c < chunks; c++ ){
+			for( int j = 0; j < 3; j++ ){
+				lo[ 0 ][ j ] = lo[ c ][ j ] < lo[ 0 ][ j ] ? lo[ c ][ j ] : lo[ 0 ][ j ];
+				hi[ 0 ][ j ] = hi[ c ][ j ] > hi[ 0 ][ j ] ? hi[ c ][ j ] : hi[ 0 ][ j ];
+			}
+		}
+		return( Obb( axes * ( ( lo[ 0 ] + hi[ 0 ] ) * 0.5 ), axes, ( hi[ 0 ] - lo[ 0 ] ) * 0.5 ) );
+	}
+
+	static bool lexicographicLess( const Vec2 & a, const Vec2 & b ){
+		return( a[ 0 ] < b[ 0 ] || ( a[ 0 ] == b[ 0 ] && a[ 1 ] < b[ 1 ] ) );
+	}
+
+	static double cross2( const Vec2 & o, const Vec2 & a, const Vec2 & b ){
+		return( ( a[ 0 ] - o[ 0 ] ) * ( b[ 1 ] - o[ 1 ] ) - ( a[ 1 ] - o[ 1 ] ) * ( b[ 0 ] - o[ 0 ] ) );
+	}
+
+	/// counterclockwise convex hull ( monotone chain ), sorts the points in place
+	static int convexHull2( std::vector< Vec2 > & points, std::vector< Vec2 > & hull ){
+		std::sort( points.begin(), points.end(), lexicographicLess );
+		int n = ( int )points.size();
+		hull.resize( 2 * n + 1 );
+		int h = 0;
+		for( int i = 0; i < n; i++ ){
+			while( h >= 2 && cross2( hull[ h - 2 ], hull[ h - 1 ], points[ i ] ) <= 0.0 ){
+				h--;
+			}
+			hull[ h++ ] = points[ i ];
+		}
+		for( int i = n - 2, lower = h + 1; i >= 0; i-- ){
+			while( h >= lower && cross2( hull[ h - 2 ], hull[ h - 1 ], points[ i ] ) <= 0.0 ){
+				h--;
+			}
+			hull[ h++ ] = points[ i ];
+		}
+		return( h > 1 ? h - 1 : h );
+	}
+
+	/// minimum area rectangle around a counterclockwise convex polygon, returns its area and
+	/// the unit direction of its first side. The three supporting points only move forward.
+	static double minimumRectangle( const Vec2 * hull, int h, Vec2 & direction ){
+		double best = HUGE_VAL;
+		int right = 0, top = 0, left = 0;
+		for( int i = 0; i < h; i++ ){
+			Vec2 e = hull[ ( i + 1 ) % h ] - hull[ i ];
+			double length = sqrt( e.dot( e ) );
+			if( length <= 0.0 ){
+				continue;
+			}
+			e /= length;
+			Vec2 n( -e[ 1 ], e[ 0 ] );
+			if( i == 0 ){
+				for( int j = 1; j < h; j++ ){
+					right = ( hull[ j ] - hull[ right ] ).dot( e ) > 0.0 ? j : right;
+					top = ( hull[ j ] - hull[ top ] ).dot( n ) > 0.0 ? j : top;
+					left = ( hull[ j ] - hull[ left ] ).dot( e ) < 0.0 ? j : left;
+				}
+			}
+			for( int steps = 0; steps < h && ( hull[ ( right + 1 ) % h ] - hull[ right ] ).dot( e ) > 0.0; steps++ ){
+				right = ( right + 1 ) % h;
+			}
+			for( int steps = 0; steps < h && ( hull[ ( top + 1 ) % h ] - hull[ top ] ).dot( n ) > 0.0; steps++ ){
+				top = ( top + 1 ) % h;
+			}
+			for( int steps = 0; steps < h && ( hull[ ( left + 1 ) % h ] - hull[ left ] ).dot( e ) < 0.0; steps++ ){
+				left = ( left + 1 ) % h;
+			}
+			double area = ( hull[ right ] - hull[ left ] ).dot( e ) * ( hull[ top ] - hull[ i ] ).dot( n );
+			if( area < best ){
+				best = area;
+				direction = e;
+			}
+		}
+		return( best );
+	}
+
+	/// smallest box that has the given column of axes as one of its edge directions
+	static Obb fitAroundAxis( const Vec3 * points, int count, const Mat3 & axes, int fixed, std::vector< Vec2 > & projected, std::vector< Vec2 > & hull ){
+		Vec3 w = axes.getCol( fixed );
+		Vec3 u = axes.getCol( ( fixed + 1 ) % 3 );
+		Vec3 v = w.cross( u );
+		projected.resize( count );
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			projected[ i ] = Vec2( u.dot( points[ i ] ), v.dot( points[ i ] ) );
+		}
+		int h = convexHull2( projected, hull );
+		Vec2 e;
+		if( h < 3 || minimumRectangle( & hull[ 0 ], h, e ) == HUGE_VAL ){
+			return( fitAxes( points, count, axes ) );
+		}
+		Vec3 a0 = u * e[ 0 ] + v * e[ 1 ];
+		Vec3 a1 = w.cross( a0 );
+		return( fitAxes( points, count, Mat3( a0, a1, w ) ) );
+	}
+
+	Obb Obb::fromPoints( const Vec3 * points, int count, bool hull ){
+		if( count <= 0 ){
+			return( Obb() );
+		}
+		Vec3 mean, eigenvalues;
+		Mat3 axes;
+		pointCovariance( points, count, mean ).eigenSymmetric( eigenvalues, axes );
+		Obb best = fitAxes( points, count, axes );
+		if( ! hull ){
+			return( best );
+		}
+		// each round tries the three axes of the best box so far as the fixed edge direction
+		std::vector< Vec2 > projected, outline;
+		for( int round = 0; round < 4; round++ ){
+			Mat3 current = best.axes();
+			bool improved = false;
+			for( int fixed = 0; fixed < 3; fixed++ ){
+				Obb candidate = fitAroundAxis( points, count, current, fixed, projected, outline );
+				if( candidate.volume() < best.volume() * ( 1.0 - 1e-9 ) ){
+					best = candidate;
+					improved = true;
+				}
+			}
+			if( ! improved ){
+				break;
+			}
+		}
+		return( best );
+	}
+
+	///--------------------------------Sphere-----------------------------
+
+	Sphere::Sphere( const Vec3 & center, double radius ) :
+		m_center( center ),
+		m_radius( radius ){
+	}
+
+	Vec3 & Sphere::center( void ){
+		return( m_center );
+	}
+
+	const Vec3 & Sphere::center( void ) const {
+		return( m_center );
+	}
+
+	double & Sphere::radius( void ){
+		return( m_radius );
+	}
+
+	double Sphere::radius( void ) const {
+		return( m_radius );
+	}
+
+	bool Sphere::contains( const Vec3 & point ) const {
+		return( distance2( point, m_center ) <= m_radius * m_radius );
+	}
+
+	/// smallest sphere around this one and the point
+	void Sphere::expand( const Vec3 & point ){
+		double d2 = distance2( point, m_center );
+		if( d2 <= m_radius * m_radius ){
+			return;
+		}
+		double d = sqrt( d2 );
+		double radius = 0.5 * ( m_radius + d );
+		m_center += ( point - m_center ) * ( ( radius - m_radius ) / d );
+		m_radius = radius;
+	}
+
+	/// index of the point farthest from the given one, MU_PACKET_SIZE lanes per pass and one
+	/// chunk per thread
+	static int farthestPoint( const Vec3 * points, int count, const Vec3 & from ){
+		int chunks = count > MU_PARALLEL_GRAIN ? maxThreads() : 1;
+		std::vector< double > chunkBest( chunks, -1.0 );
+		std::vector< int > chunkIndex( chunks, 0 );
+		MU_PRAGMA( omp parallel for schedule( static, 1 ) num_threads( chunks ) )
+		for( int c = 0; c < chunks; c++ ){
+			int lo = ( int )( ( long long )count * c / chunks );
+			int hi = ( int )( ( long long )count * ( c + 1 ) / chunks );
+			double best[ MU_PACKET_SIZE ];
+			int index[ MU_PACKET_SIZE ];
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				best[ i ] = -1.0;
+				index[ i ] = lo;
+			}
+			for( int base = lo; base < hi; base += MU_PACKET_SIZE ){
+				int lanes = hi - base < MU_PACKET_SIZE ? hi - base : MU_PACKET_SIZE;
+				for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+					int point = base + ( i < lanes ? i : 0 );
+					double dx = points[ point ][ 0 ] - from[ 0 ];
+					double dy = points[ point ][ 1 ] - from[ 1 ];
+					double dz = points[ point ][ 2 ] - from[ 2 ];
+					double d2 = dx * dx + dy * dy + dz * dz;
+					index[ i ] = d2 > best[ i ] ? point : index[ i ];
+					best[ i ] = d2 > best[ i ] ? d2 : best[ i ];
+				}
+			}
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				if( best[ i ] > chunkBest[ c ] ){
+					chunkBest[ c ] = best[ i ];
+					chunkIndex[ c ] = index[ i ];
+				}
+			}
+		}
+		int farthest = 0;
+		for( int c = 1; c < chunks; c++ ){
+			farthest = chunkBest[ c ] > chunkBest[ farthest ] ? c : farthest;
+		}
+		return( chunkIndex[ farthest ] );
+	}
+
+	static Sphere ritterSphere( const Vec3 * points, int count ){
+		int a = farthestPoint( points, count, points[ 0 ] );
+		int b = farthestPoint( points, count, points[ a ] );
+		Sphere sphere( ( points[ a ] + points[ b ] ) * 0.5, 0.5 * distance( points[ a ], points[ b ] ) );
+
+		// growing depends on every earlier point, so only the outside test runs on packets
+		double lx[ MU_PACKET_SIZE ], ly[ MU_PACKET_SIZE ], lz[ MU_PACKET_SIZE ], ld[ MU_PACKET_SIZE ];
+		for( int base = 0; base < count; base += MU_PACKET_SIZE ){
+			int lanes = count - base < MU_PACKET_SIZE ? count - base : MU_PACKET_SIZE;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				int point = base + ( i < lanes ? i : 0 );
+				lx[ i ] = points[ point ][ 0 ];
+				ly[ i ] = points[ point ][ 1 ];
+				lz[ i ] = points[ point ][ 2 ];
+			}
+			const Vec3 & c = sphere.center();
+			double farthest = 0.0;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				double dx = lx[ i ] - c[ 0 ], dy = ly[ i ] - c[ 1 ], dz = lz[ i ] - c[ 2 ];
+				ld[ i ] = dx * dx + dy * dy + dz * dz;
+				farthest = ld[ i ] > farthest ? ld[ i ] : farthest;
+			}
+			if( farthest > sphere.radius() * sphere.radius() ){
+				for( int i = 0; i < lanes; i++ ){
+					sphere.expand( points[ base + i ] );
+				}
+			}
+		}
+		return( sphere );
+	}
+
+	/// smallest sphere with all support points on its surface, 1 to 4 points
+	static Sphere supportSphere( const Vec3 * support, int count ){
+		if( count == 0 ){
+			return( Sphere( Vec3( 0.0 ), -1.0 ) );
+		}
+		const Vec3 & o = support[ 0 ];
+		if( count == 1 ){
+			return( Sphere( o, 0.0 ) );
+		}
+		if( count == 2 ){
+			return( Sphere( ( o + support[ 1 ] ) * 0.5, 0.5 * distance( o, support[ 1 ] ) ) );
+		}
+		Vec3 a = support[ 1 ] - o;
+		Vec3 b = support[ 2 ] - o;
+		Vec3 n = a.cross( b );
+		if( count == 4 ){
+			Vec3 c = support[ 3 ] - o;
+			double det = 2.0 * a.dot( b.cross( c ) );
+			if( fabs( det ) > DBL_EPSILON * a.hyp() * sqrt( b.hyp() * c.hyp() ) ){
+				Vec3 offset = ( b.cross( c ) * a.hyp() + c.cross( a ) * b.hyp() + n * c.hyp() ) / det;
+				return( Sphere( o + offset, offset.len() ) );
+			}
+		}
+		double n2 = n.hyp();
+		if( n2 <= DBL_EPSILON * a.hyp() * b.hyp() ){
+			// collinear, the two points farthest apart span the sphere
+			Vec3 ends[ 2 ] = { o, support[ 1 ] };
+			double d01 = a.hyp(), d02 = b.hyp(), d12 = distance2( support[ 1 ], support[ 2 ] );
+			if( d02 >= d01 && d02 >= d12 ){
+				ends[ 1 ] = support[ 2 ];
+			}
+			else if( d12 >= d01 ){
+				ends[ 0 ] = support[ 2 ];
+			}
+			return( supportSphere( ends, 2 ) );
+		}
+		Vec3 offset = ( b * a.hyp() - a * b.hyp() ).cross( n ) / ( 2.0 * n2 );
+		return( Sphere( o + offset, offset.len() ) );
+	}
+
+	/// Welzl's recursion over a linked list of point indices. Points found outside are moved
+	/// to the front, so later calls meet the likely support points first.
+	static Sphere moveToFront( const Vec3 * points, int * next, int * previous, int & head, int end, Vec3 * support, int supportCount ){
+		Sphere sphere = supportSphere( support, supportCount );
+		if( supportCount == 4 ){
+			return( sphere );
+		}
+		for( int i = head; i != end; ){
+			int following = next[ i ];
+			double d2 = distance2( points[ i ], sphere.center() );
+			double r2 = sphere.radius() * sphere.radius();
+			if( sphere.radius() < 0.0 || d2 > r2 + 1e-12 * ( r2 + d2 ) ){
+				support[ supportCount ] = points[ i ];
+				sphere = moveToFront( points, next, previous, head, i, support, supportCount + 1 );
+				if( i != head ){
+					next[ previous[ i ] ] = next[ i ];
+					if( next[ i ] >= 0 ){
+						previous[ next[ i ] ] = previous[ i ];
+					}
+					next[ i ] = head;
+					previous[ head ] = i;
+					head = i;
+				}
+			}
+			i = following;
+		}
+		return( sphere );
+	}
+
+	static Sphere welzlSphere( const Vec3 * points, int count ){
+		// a fixed pseudo random visiting order gives the expected linear time on sorted input
+		std::vector< int > order( count );
+		for( int i = 0; i < count; i++ ){
+			order[ i ] = i;
+		}
+		uint64_t state = 0x9e3779b97f4a7c15ULL;
+		for( int i = count - 1; i > 0; i-- ){
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			std::swap( order[ i ], order[ ( int )( ( state >> 33 ) % ( uint64_t )( i + 1 ) ) ] );
+		}
+		std::vector< Vec3 > shuffled( count );
+		std::vector< int > next( count ), previous( count );
+		for( int i = 0; i < count; i++ ){
+			shuffled[ i ] = points[ order[ i ] ];
+			next[ i ] = i + 1 < count ? i + 1 : -1;
+			previous[ i ] = i - 1;
+		}
+		Vec3 support[ 4 ];
+		int head = 0;
+		return( moveToFront( & shuffled[ 0 ], & next[ 0 ], & previous[ 0 ], head, -1, support, 0 ) );
+	}
+
+	Sphere Sphere::fromPoints( const Vec3 * points, int count, bool exact ){
+		if( count <= 0 ){
+			return( Sphere() );
+		}
+		return( exact ? welzlSphere( points, count ) : ritterSphere( points, count ) );
+	}
+
+	///--------------------------------predicates-------------------------
+
+	/// exact sums and products of doubles as nonoverlapping expansions, smallest component
+	/// first. Only reached when the floating point filter of a predicate is inconclusive.
+	/// A type of its own so the operators below never apply to plain double vectors.
+	struct Expansion : public std::vector< double > {
+	};
+
+	static const double predicateEpsilon = 1.1102230246251565e-16;	// 2^-53
+	static const double predicateSplitter = 134217729.0;			// 2^27 + 1
+	static const double ccwErrorBound = ( 3.0 + 16.0 * predicateEpsilon ) * predicateEpsilon;
+	static const double o3dErrorBound = ( 7.0 + 56.0 * predicateEpsilon ) * predicateEpsilon;
+	static const double iccErrorBound = ( 10.0 + 96.0 * predicateEpsilon ) * predicateEpsilon;
+	static const double ispErrorBound = ( 16.0 + 224.0 * predicateEpsilon ) * predicateEpsilon;
+
+	static inline void twoSum( double a, double b, double & x, double & y ){
+		x = a + b;
+		double bv = x - a;
+		double av = x - bv;
+		y = ( a - av ) + ( b - bv );
+	}
+
+	static inline void twoDiff( double a, double b, double & x, double & y ){
+		x = a - b;
+		double bv = a - x;
+		double av = x + bv;
+		y = ( a - av ) + ( bv - b );
+	}
+
+	static inline void split( double a, double & hi, double & lo ){
+		double c = predicateSplitter * a;
+		hi = c - ( c - a );
+		lo = a - hi;
+	}
+
+	static inline void twoProduct( double a, double b, double & x, double & y ){
+		x = a * b;
+		double ahi, alo, bhi, blo;
+		split( a, ahi, alo );
+		split( b, bhi, blo );
+		y = alo * blo - ( ( ( x - ahi * bhi ) - alo * bhi ) - ahi * blo );
+	}
+
+	/// a - b exactly
+	static Expansion difference( double a, double b ){
+		double x, y;
+		twoDiff( a, b, x, y );
+		Expansion e;
+		if( y != 0.0 ){
+			e.push_back( y );
+		}
+		if( x != 0.0 ){
+			e.push_back( x );
+		}
+		return( e );
+	}
+
+	/// h = e + f, zero components eliminated
+	static Expansion operator + ( const Expansion & e, const Expansion & f ){
+		Expansion h;
+		size_t ei = 0, fi = 0;
+		if( e.empty() || f.empty() ){
+			return( e.empty() ? f : e );
+		}
+		h.reserve( e.size() + f.size() );
+		double q, qnew, hh;
+		double enow = e[ 0 ], fnow = f[ 0 ];
+		if( ( fnow > enow ) == ( fnow > -enow ) ){
+			q = enow;
+			enow = ++ei < e.size() ? e[ ei ] : 0.0;
+		}
+		else{
+			q = fnow;
+			fnow = ++fi < f.size() ? f[ fi ] : 0.0;
+		}
+		if( ei < e.size() && fi < f.size() ){
+			if( ( fnow > enow ) == ( fnow > -enow ) ){
+				qnew = enow + q;
+				hh = q - ( qnew - enow );
+				enow = ++ei < e.size() ? e[ ei ] : 0.0;
+			}
+			else{
+				qnew = fnow + q;
+				hh = q - ( qnew - fnow );
+				fnow = ++fi < f.size() ? f[ fi ] : 0.0;
+			}
+			q = qnew;
+			if( hh != 0.0 ){
+				h.push_back( hh );
+			}
+			while( ei < e.size() && fi < f.size() ){
+				if( ( fnow > enow ) == ( fnow > -enow ) ){
+					twoSum( q, enow, qnew, hh );
+					enow = ++ei < e.size() ? e[ ei ] : 0.0;
+				}
+				else{
+					twoSum( q, fnow, qnew, hh );
+					fnow = ++fi < f.size() ? f[ fi ] : 0.0;
+				}
+				q = qnew;
+				if( hh != 0.0 ){
+					h.push_back( hh );
+				}
+			}
+		}
+		while( ei < e.size() ){
+			twoSum( q, enow, qnew, hh );
+			enow = ++ei < e.size() ? e[ ei ] : 0.0;
+			q = qnew;
+			if( hh != 0.0 ){
+				h.push_back( hh );
+			}
+		}
+		while( fi < f.size() ){
+			twoSum( q, fnow, qnew, hh );
+			fnow = ++fi < f.size() ? f[ fi ] : 0.0;
+			q = qnew;
+			if( hh != 0.0 ){
+				h.push_back( hh );
+			}
+		}
+		if( q != 0.0 || h.empty() ){
+			h.push_back( q );
+		}
+		return( h );
+	}
+
+	static Expansion operator - ( const Expansion & e ){
+		Expansion h( e );
+		for( size_t i = 0; i < h.size(); i++ ){
+			h[ i ] = -h[ i ];
+		}
+		return( h );
+	}
+
+	static Expansion operator - ( const Expansion & e, const Expansion & f ){
+		return( e + -f );
+	}
+
+	/// h = e * b, zero components eliminated
+	static Expansion operator * ( const Expansion & e, double b ){
+		Expansion h;
+		if( e.empty() || b == 0.0 ){
+			return( h );
+		}
+		h.reserve( 2 * e.size() );
+		double q, hh, product1, product0, sum;
+		twoProduct( e[ 0 ], b, q, hh );
+		if( hh != 0.0 ){
+			h.push_back( hh );
+		}
+		for( size_t i = 1; i < e.size(); i++ ){
+			twoProduct( e[ i ], b, product1, product0 );
+			twoSum( q, product0, sum, hh );
+			if( hh != 0.0 ){
+				h.push_back( hh );
+			}
+			twoSum( product1, sum, q, hh );
+			if( hh != 0.0 ){
+				h.push_back( hh );
+			}
+		}
+		if( q != 0.0 || h.empty() ){
+			h.push_back( q );
+		}
+		return( h );
+	}
+
+	static Expansion operator * ( const Expansion & e, const Expansion & f ){
+		Expansion h;
+		for( size_t i = 0; i < f.size(); i++ ){
+			h = h + e * f[ i ];
+		}
+		return( h );
+	}
+
+	/// the largest component carries the sign
+	static double estimate( const Expansion & e ){
+		return( e.empty() ? 0.0 : e.back() );
+	}
+
+	double orient2d( const Vec2 & a, const Vec2 & b, const Vec2 & c ){
+		double left = ( a[ 0 ] - c[ 0 ] ) * ( b[ 1 ] - c[ 1 ] );
+		double right = ( a[ 1 ] - c[ 1 ] ) * ( b[ 0 ] - c[ 0 ] );
+		double det = left - right;
+		if( ( left > 0.0 && right <= 0.0 ) || ( left < 0.0 && right >= 0.0 ) ){
+			return( det );
+		}
+		if( fabs( det ) >= ccwErrorBound * ( fabs( left ) + fabs( right ) ) ){
+			return( det );
+		}
+		Expansion acx = difference( a[ 0 ], c[ 0 ] ), acy = difference( a[ 1 ], c[ 1 ] );
+		Expansion bcx = difference( b[ 0 ], c[ 0 ] ), bcy = difference( b[ 1 ], c[ 1 ] );
+		return( estimate( acx * bcy - acy * bcx ) );
+	}
+
+	double orient3d( const Vec3 & a, const Vec3 & b, const Vec3 & c, const Vec3 & d ){
+		double adx = a[ 0 ] - d[ 0 ], ady = a[ 1 ] - d[ 1 ], adz = a[ 2 ] - d[ 2 ];
+		double bdx = b[ 0 ] - d[ 0 ], bdy = b[ 1 ] - d[ 1 ], bdz = b[ 2 ] - d[ 2 ];
+		double cdx = c[ 0 ] - d[ 0 ], cdy = c[ 1 ] - d[ 1 ], cdz = c[ 2 ] - d[ 2 ];
+		double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+		double cdxady = cdx * ady, adxcdy = adx * cdy;
+		double adxbdy = adx * bdy, bdxady = bdx * ady;
+		double det = adz * ( bdxcdy - cdxbdy ) + bdz * ( cdxady - adxcdy ) + cdz * ( adxbdy - bdxady );
+		double permanent = ( fabs( bdxcdy ) + fabs( cdxbdy ) ) * fabs( adz )
+						+ ( fabs( cdxady ) + fabs( adxcdy ) ) * fabs( bdz )
+						+ ( fabs( adxbdy ) + fabs( bdxady ) ) * fabs( cdz );
+		if( fabs( det ) >= o3dErrorBound * permanent ){
+			return( det );
+		}
+		Expansion ex[ 3 ], ey[ 3 ], ez[ 3 ];
+		const Vec3 * p[ 3 ] = { & a, & b, & c };
+		for( int i = 0; i < 3; i++ ){
+			ex[ i ] = difference( ( *p[ i ] )[ 0 ], d[ 0 ] );
+			ey[ i ] = difference( ( *p[ i ] )[ 1 ], d[ 1 ] );
+			ez[ i ] = difference( ( *p[ i ] )[ 2 ], d[ 2 ] );
+		}
+		Expansion bc = ex[ 1 ] * ey[ 2 ] - ex[ 2 ] * ey[ 1 ];
+		Expansion ca = ex[ 2 ] * ey[ 0 ] - ex[ 0 ] * ey[ 2 ];
+		Expansion ab = ex[ 0 ] * ey[ 1 ] - ex[ 1 ] * ey[ 0 ];
+		return( estimate( ez[ 0 ] * bc + ez[ 1 ] * ca + ez[ 2 ] * ab ) );
+	}
+
+	double incircle( const Vec2 & a, const Vec2 & b, const Vec2 & c, const Vec2 & d ){
+		double adx = a[ 0 ] - d[ 0 ], ady = a[ 1 ] - d[ 1 ];
+		double bdx = b[ 0 ] - d[ 0 ], bdy = b[ 1 ] - d[ 1 ];
+		double cdx = c[ 0 ] - d[ 0 ], cdy = c[ 1 ] - d[ 1 ];
+		double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+		double cdxady = cdx * ady, adxcdy = adx * cdy;
+		double adxbdy = adx * bdy, bdxady = bdx * ady;
+		double alift = adx * adx + ady * ady;
+		double blift = bdx * bdx + bdy * bdy;
+		double clift = cdx * cdx + cdy * cdy;
+		double det = alift * ( bdxcdy - cdxbdy ) + blift * ( cdxady - adxcdy ) + clift * ( adxbdy - bdxady );
+		double permanent = ( fabs( bdxcdy ) + fabs( cdxbdy ) ) * alift
+						+ ( fabs( cdxady ) + fabs( adxcdy ) ) * blift
+						+ ( fabs( adxbdy ) + fabs( bdxady ) ) * clift;
+		if( fabs( det ) >= iccErrorBound * permanent ){
+			return( det );
+		}
+		Expansion ex[ 3 ], ey[ 3 ], lift[ 3 ];
+		const Vec2 * p[ 3 ] = { & a, & b, & c };
+		for( int i = 0; i < 3; i++ ){
+			ex[ i ] = difference( ( *p[ i ] )[ 0 ], d[ 0 ] );
+			ey[ i ] = difference( ( *p[ i ] )[ 1 ], d[ 1 ] );
+			lift[ i ] = ex[ i ] * ex[ i ] + ey[ i ] * ey[ i ];
+		}
+		Expansion bc = ex[ 1 ] * ey[ 2 ] - ex[ 2 ] * ey[ 1 ];
+		Expansion ca = ex[ 2 ] * ey[ 0 ] - ex[ 0 ] * ey[ 2 ];
+		Expansion ab = ex[ 0 ] * ey[ 1 ] - ex[ 1 ] * ey[ 0 ];
+		return( estimate( lift[ 0 ] * bc + lift[ 1 ] * ca + lift[ 2 ] * ab ) );
+	}
+
+	double insphere( const Vec3 & a, const Vec3 & b, const Vec3 & c, const Vec3 & d, const Vec3 & e ){
+		double aex = a[ 0 ] - e[ 0 ], aey = a[ 1 ] - e[ 1 ], aez = a[ 2 ] - e[ 2 ];
+		double bex = b[ 0 ] - e[ 0 ], bey = b[ 1 ] - e[ 1 ], bez = b[ 2 ] - e[ 2 ];
+		double cex = c[ 0 ] - e[ 0 ], cey = c[ 1 ] - e[ 1 ], cez = c[ 2 ] - e[ 2 ];
+		double dex = d[ 0 ] - e[ 0 ], dey = d[ 1 ] - e[ 1 ], dez = d[ 2 ] - e[ 2 ];
+		double aexbey = aex * bey, bexaey = bex * aey;
+		double bexcey = bex * cey, cexbey = cex * bey;
+		double cexdey = cex * dey, dexcey = dex * cey;
+		double dexaey = dex * aey, aexdey = aex * dey;
+		double aexcey = aex * cey, cexaey = cex * aey;
+		double bexdey = bex * dey, dexbey = dex * bey;
+		double ab = aexbey - bexaey, bc = bexcey - cexbey, cd = cexdey - dexcey;
+		double da = dexaey - aexdey, ac = aexcey - cexaey, bd = bexdey - dexbey;
+		double abc = aez * bc - bez * ac + cez * ab;
+		double bcd = bez * cd - cez * bd + dez * bc;
+		double cda = cez * da + dez * ac + aez * cd;
+		double dab = dez * ab + aez * bd + bez * da;
+		double alift = aex * aex + aey * aey + aez * aez;
+		double blift = bex * bex + bey * bey + bez * bez;
+		double clift = cex * cex + cey * cey + cez * cez;
+		double dlift = dex * dex + dey * dey + dez * dez;
+		double det = ( dlift * abc - clift * dab ) + ( blift * cda - alift * bcd );
+		double aezplus = fabs( aez ), bezplus = fabs( bez ), cezplus = fabs( cez ), dezplus = fabs( dez );
+		double aexbeyplus = fabs( aexbey ), bexaeyplus = fabs( bexaey );
+		double bexceyplus = fabs( bexcey ), cexbeyplus = fabs( cexbey );
+		double cexdeyplus = fabs( cexdey ), dexceyplus = fabs( dexcey );
+		double dexaeyplus = fabs( dexaey ), aexdeyplus = fabs( aexdey );
+		double aexceyplus = fabs( aexcey ), cexaeyplus = fabs( cexaey );
+		double bexdeyplus = fabs( bexdey ), dexbeyplus = fabs( dexbey );
+		double permanent = ( ( cexdeyplus + dexceyplus ) * bezplus + ( dexbeyplus + bexdeyplus ) * cezplus + ( bexceyplus + cexbeyplus ) * dezplus ) * alift
+						+ ( ( dexaeyplus + aexdeyplus ) * cezplus + ( aexceyplus + cexaeyplus ) * dezplus + ( cexdeyplus + dexceyplus ) * aezplus ) * blift
+						+ ( ( aexbeyplus + bexaeyplus ) * dezplus + ( bexdeyplus + dexbeyplus ) * aezplus + ( dexaeyplus + aexdeyplus ) * bezplus ) * clift
+						+ ( ( bexceyplus + cexbeyplus ) * aezplus + ( cexaeyplus + aexceyplus ) * bezplus + ( aexbeyplus + bexaeyplus ) * cezplus ) * dlift;
+		if( fabs( det ) >= ispErrorBound * permanent ){
+			return( det );
+		}
+		Expansion ex[ 4 ], ey[ 4 ], ez[ 4 ], lift[ 4 ];
+		const Vec3 * p[ 4 ] = { & a, & b, & c, & d };
+		for( int i = 0; i < 4; i++ ){
+			ex[ i ] = difference( ( *p[ i ] )[ 0 ], e[ 0 ] );
+			ey[ i ] = difference( ( *p[ i ] )[ 1 ], e[ 1 ] );
+			ez[ i ] = difference( ( *p[ i ] )[ 2 ], e[ 2 ] );
+			lift[ i ] = ex[ i ] * ex[ i ] + ey[ i ] * ey[ i ] + ez[ i ] * ez[ i ];
+		}
+		Expansion xab = ex[ 0 ] * ey[ 1 ] - ex[ 1 ] * ey[ 0 ];
+		Expansion xbc = ex[ 1 ] * ey[ 2 ] - ex[ 2 ] * ey[ 1 ];
+		Expansion xcd = ex[ 2 ] * ey[ 3 ] - ex[ 3 ] * ey[ 2 ];
+		Expansion xda = ex[ 3 ] * ey[ 0 ] - ex[ 0 ] * ey[ 3 ];
+		Expansion xac = ex[ 0 ] * ey[ 2 ] - ex[ 2 ] * ey[ 0 ];
+		Expansion xbd = ex[ 1 ] * ey[ 3 ] - ex[ 3 ] * ey[ 1 ];
+		Expansion xabc = ez[ 0 ] * xbc - ez[ 1 ] * xac + ez[ 2 ] * xab;
+		Expansion xbcd = ez[ 1 ] * xcd - ez[ 2 ] * xbd + ez[ 3 ] * xbc;
+		Expansion xcda = ez[ 2 ] * xda + ez[ 3 ] * xac + ez[ 0 ] * xcd;
+		Expansion xdab = ez[ 3 ] * xab + ez[ 0 ] * xbd + ez[ 1 ] * xda;
+		return( estimate( ( lift[ 3 ] * xabc - lift[ 2 ] * xdab ) + ( lift[ 1 ] * xcda - lift[ 0 ] * xbcd ) ) );
+	}
+
+	///--------------------------------convex hull------------------------
+
+	/// edge i runs from vertex[ i ] to vertex[ ( i + 1 ) % 3 ] and is shared with neighbour[ i ]
+	struct HullFace {
+		int vertex[ 3 ];
+		int neighbour[ 3 ];
+		Vec3 normal;
+		double offset;
+		int farthest;
+		double farthestDistance;
+		bool alive;
+		bool visible;
+	};
+
+	static HullFace makeHullFace( const Vec3 * points, int a, int b, int c ){
+		HullFace face;
+		face.vertex[ 0 ] = a;
+		face.vertex[ 1 ] = b;
+		face.vertex[ 2 ] = c;
+		face.neighbour[ 0 ] = face.neighbour[ 1 ] = face.neighbour[ 2 ] = -1;
+		Vec3 n = ( points[ b ] - points[ a ] ).cross( points[ c ] - points[ a ] );
+		double length = sqrt( n.hyp() );
+		face.normal = length > 0.0 ? n / length : n;
+		face.offset = face.normal.dot( ( points[ a ] + points[ b ] + points[ c ] ) / 3.0 );
+		face.farthest = -1;
+		face.farthestDistance = -HUGE_VAL;
+		face.alive = true;
+		face.visible = false;
+		return( face );
+	}
+
+	static double hullDistance( const HullFace & face, const Vec3 & point ){
+		return( face.normal.dot( point ) - face.offset );
+	}
+
+	/// exact test for point strictly above the face, coplanar points are not
+	static bool hullAbove( const Vec3 * points, const HullFace & face, const Vec3 & point ){
+		return( orient3d( points[ face.vertex[ 0 ] ], points[ face.vertex[ 1 ] ], points[ face.vertex[ 2 ] ], point ) < 0.0 );
+	}
+
+	/// moves every candidate point to the outside set of the face among faces[ first, last )
+	/// it lies farthest above, points on or below all of them are inside the hull and dropped.
+	/// Above is decided by orient3d, the plane distance only ranks. The tests run in parallel,
+	/// the buckets are filled afterwards in candidate order.
+	static void assignToFaces( const Vec3 * points, const std::vector< int > & candidates, std::vector< HullFace > & faces, int first, int last, std::vector< int > & owner, std::vector< double > & height, std::vector< std::vector< int > > & outside ){
+		int count = ( int )candidates.size();
+		owner.resize( count );
+		height.resize( count );
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			const Vec3 & p = points[ candidates[ i ] ];
+			int best = -1;
+			double bestHeight = -HUGE_VAL;
+			for( int f = first; f < last; f++ ){
+				double d = hullDistance( faces[ f ], p );
+				if( d > bestHeight && hullAbove( points, faces[ f ], p ) ){
+					best = f;
+					bestHeight = d;
+				}
+			}
+			owner[ i ] = best;
+			height[ i ] = bestHeight;
+		}
+		for( int i = 0; i < count; i++ ){
+			int f = owner[ i ];
+			if( f < 0 ){
+				continue;
+			}
+			outside[ f ].push_back( candidates[ i ] );
+			if( height[ i ] > faces[ f ].farthestDistance ){
+				faces[ f ].farthestDistance = height[ i ];
+				faces[ f ].farthest = candidates[ i ];
+			}
+		}
+	}
+
+	/// indices of the smallest and largest point along each axis, one chunk per thread
+	static void axisExtremes( const Vec3 * points, int count, int * extremes ){
+		int chunks = count > MU_PARALLEL_GRAIN ? maxThreads() : 1;
+		std::vector< int > partial( chunks * 6, 0 );
+		MU_PRAGMA( omp parallel for schedule( static, 1 ) num_threads( chunks ) )
+		for( int c = 0; c < chunks; c++ ){
+			int * e = & partial[ c * 6 ];
+			int lo = ( int )( ( long long )count * c / chunks );
+			int hi = ( int )( ( long long )count * ( c + 1 ) / chunks );
+			for( int j = 0; j < 6; j++ ){
+				e[ j ] = lo;
+			}
+			for( int i = lo + 1; i < hi; i++ ){
+				for( int j = 0; j < 3; j++ ){
+					e[ j ] = points[ i ][ j ] < points[ e[ j ] ][ j ] ? i : e[ j ];
+					e[ j + 3 ] = points[ i ][ j ] > points[ e[ j + 3 ] ][ j ] ? i : e[ j + 3 ];
+				}
+			}
+		}
+		for( int j = 0; j < 6; j++ ){
+			extremes[ j ] = partial[ j ];
+		}
+		for( int c = 1; c < chunks; c++ ){
+			for( int j = 0; j < 3; j++ ){
+				int lo = partial[ c * 6 + j ], hi = partial[ c * 6 + j + 3 ];
+				extremes[ j ] = points[ lo ][ j ] < points[ extremes[ j ] ][ j ] ? lo : extremes[ j ];
+				extremes[ j + 3 ] = points[ hi ][ j ] > points[ extremes[ j + 3 ] ][ j ] ? hi : extremes[ j + 3 ];
+			}
+		}
+	}
+
+	int convexHull( const Vec3 * points, int count, std::vector< int > & triangles ){
+		triangles.clear();
+		if( count < 4 ){
+			return( 0 );
+		}
+
+		// tolerance scaled to the coordinate magnitude, only to reject inputs without volume
+		// while picking the initial simplex, the hull itself is built on orient3d
+		int extremes[ 6 ];
+		axisExtremes( points, count, extremes );
+		double epsilon = 0.0;
+		for( int j = 0; j < 3; j++ ){
+			epsilon += largest( fabs( points[ extremes[ j ] ][ j ] ), fabs( points[ extremes[ j + 3 ] ][ j ] ) );
+		}
+		epsilon *= 3.0 * DBL_EPSILON;
+
+		// initial tetrahedron from the extremes
+		int simplex[ 4 ] = { extremes[ 0 ], extremes[ 3 ], 0, 0 };
+		double best = -1.0;
+		for( int i = 0; i < 6; i++ ){
+			for( int j = i + 1; j < 6; j++ ){
+				double d2 = distance2( points[ extremes[ i ] ], points[ extremes[ j ] ] );
+				if( d2 > best ){
+					best = d2;
+					simplex[ 0 ] = extremes[ i ];
+					simplex[ 1 ] = extremes[ j ];
+				}
+			}
+		}
+		if( sqrt( best ) <= epsilon ){
+			return( 0 );
+		}
+		const Vec3 & a = points[ simplex[ 0 ] ];
+		Vec3 axis = ( points[ simplex[ 1 ] ] - a ) / sqrt( best );
+		best = -1.0;
+		for( int i = 0; i < count; i++ ){
+			double d2 = ( points[ i ] - a ).cross( axis ).hyp();
+			if( d2 > best ){
+				best = d2;
+				simplex[ 2 ] = i;
+			}
+		}
+		if( sqrt( best ) <= epsilon ){
+			return( 0 );
+		}
+		HullFace base = makeHullFace( points, simplex[ 0 ], simplex[ 1 ], simplex[ 2 ] );
+		best = -1.0;
+		for( int i = 0; i < count; i++ ){
+			double d = fabs( hullDistance( base, points[ i ] ) );
+			if( d > best ){
+				best = d;
+				simplex[ 3 ] = i;
+			}
+		}
+		double orientation = orient3d( points[ simplex[ 0 ] ], points[ simplex[ 1 ] ], points[ simplex[ 2 ] ], points[ simplex[ 3 ] ] );
+		for( int i = 0; orientation == 0.0 && i < count; i++ ){
+			orientation = orient3d( points[ simplex[ 0 ] ], points[ simplex[ 1 ] ], points[ simplex[ 2 ] ], points[ i ] );
+			simplex[ 3 ] = i;
+		}
+		if( orientation == 0.0 ){
+			return( 0 );
+		}
+		if( orientation < 0.0 ){
+			std::swap( simplex[ 1 ], simplex[ 2 ] );
+		}
+
+		// faces 0..3 are opposite vertices 3, 0, 1, 2 of the now positively oriented simplex
+		std::vector< HullFace > faces;
+		faces.push_back( makeHullFace( points, simplex[ 0 ], simplex[ 1 ], simplex[ 2 ] ) );
+		faces.push_back( makeHullFace( points, simplex[ 1 ], simplex[ 3 ], simplex[ 2 ] ) );
+		faces.push_back( makeHullFace( points, simplex[ 0 ], simplex[ 2 ], simplex[ 3 ] ) );
+		faces.push_back( makeHullFace( points, simplex[ 0 ], simplex[ 3 ], simplex[ 1 ] ) );
+		for( int f = 0; f < 4; f++ ){
+			for( int e = 0; e < 3; e++ ){
+				int from = faces[ f ].vertex[ e ], to = faces[ f ].vertex[ ( e + 1 ) % 3 ];
+				for( int g = 0; g < 4; g++ ){
+					for( int k = 0; k < 3; k++ ){
+						if( faces[ g ].vertex[ k ] == to && faces[ g ].vertex[ ( k + 1 ) % 3 ] == from ){
+							faces[ f ].neighbour[ e ] = g;
+						}
+					}
+				}
+			}
+		}
+
+		std::vector< std::vector< int > > outside( 4 );
+		std::vector< int > candidates( count ), owner;
+		std::vector< double > height;
+		for( int i = 0; i < count; i++ ){
+			candidates[ i ] = i;
+		}
+		assignToFaces( points, candidates, faces, 0, 4, owner, height, outside );
+
+		std::vector< int > pending, visible, stack, startSlot( count, -1 );
+		std::vector< std::pair< int, int > > horizon;
+		for( int f = 0; f < 4; f++ ){
+			pending.push_back( f );
+		}
+		while( ! pending.empty() ){
+			int f = pending.back();
+			pending.pop_back();
+			if( ! faces[ f ].alive || outside[ f ].empty() ){
+				continue;
+			}
+			int eye = faces[ f ].farthest;
+			const Vec3 & e = points[ eye ];
+
+			// faces seen from the eye form a connected cap, its border is the horizon
+			visible.clear();
+			stack.push_back( f );
+			faces[ f ].visible = true;
+			while( ! stack.empty() ){
+				int g = stack.back();
+				stack.pop_back();
+				visible.push_back( g );
+				for( int k = 0; k < 3; k++ ){
+					int h = faces[ g ].neighbour[ k ];
+					if( ! faces[ h ].visible && hullAbove( points, faces[ h ], e ) ){
+						faces[ h ].visible = true;
+						stack.push_back( h );
+					}
+				}
+			}
+			horizon.clear();
+			for( size_t i = 0; i < visible.size(); i++ ){
+				for( int k = 0; k < 3; k++ ){
+					if( ! faces[ faces[ visible[ i ] ].neighbour[ k ] ].visible ){
+						horizon.push_back( std::make_pair( visible[ i ], k ) );
+					}
+				}
+			}
+
+			// a fan of new faces from the horizon to the eye
+			int first = ( int )faces.size();
+			for( size_t i = 0; i < horizon.size(); i++ ){
+				const HullFace & g = faces[ horizon[ i ].first ];
+				int k = horizon[ i ].second;
+				int from = g.vertex[ k ], to = g.vertex[ ( k + 1 ) % 3 ], h = g.neighbour[ k ];
+				int created = ( int )faces.size();
+				HullFace face = makeHullFace( points, from, to, eye );
+				face.neighbour[ 0 ] = h;
+				for( int j = 0; j < 3; j++ ){
+					if( faces[ h ].vertex[ j ] == to && faces[ h ].neighbour[ j ] == horizon[ i ].first ){
+						faces[ h ].neighbour[ j ] = created;
+					}
+				}
+				faces.push_back( face );
+				startSlot[ from ] = created;
+			}
+			int last = ( int )faces.size();
+			for( int g = first; g < last; g++ ){
+				int next = startSlot[ faces[ g ].vertex[ 1 ] ];
+				faces[ g ].neighbour[ 1 ] = next;
+				faces[ next ].neighbour[ 2 ] = g;
+			}
+			for( int g = first; g < last; g++ ){
+				startSlot[ faces[ g ].vertex[ 0 ] ] = -1;
+			}
+
+			// points of the removed cap go to the new faces
+			candidates.clear();
+			for( size_t i = 0; i < visible.size(); i++ ){
+				int g = visible[ i ];
+				faces[ g ].alive = false;
+				for( size_t j = 0; j < outside[ g ].size(); j++ ){
+					if( outside[ g ][ j ] != eye ){
+						candidates.push_back( outside[ g ][ j ] );
+					}
+				}
+				std::vector< int >().swap( outside[ g ] );
+			}
+			outside.resize( last );
+			assignToFaces( points, candidates, faces, first, last, owner, height, outside );
+			for( int g = first; g < last; g++ ){
+				if( ! outside[ g ].empty() ){
+					pending.push_back( g );
+				}
+			}
+		}
+
+		for( size_t f = 0; f < faces.size(); f++ ){
+			if( faces[ f ].alive ){
+				triangles.push_back( faces[ f ].vertex[ 0 ] );
+				triangles.push_back( faces[ f ].vertex[ 1 ] );
+				triangles.push_back( faces[ f ].vertex[ 2 ] );
+			}
+		}
+		return( ( int )triangles.size() / 3 );
+	}
+
+	///--------------------------------delaunay---------------------------
+
+	/// distance along the order 2^16 Hilbert curve through the grid cell ( x, y )
+	static uint64_t hilbertDistance2( unsigned int x, unsigned int y ){
+		uint64_t d = 0;
+		for( unsigned int s = 1u << 15; s > 0; s >>= 1 ){
+			unsigned int rx = ( x & s ) > 0;
+			unsigned int ry = ( y & s ) > 0;
+			d += ( uint64_t )s * s * ( ( 3 * rx ) ^ ry );
+			if( ry == 0 ){
+				if( rx == 1 ){
+					x = s - 1 - ( x & ( s - 1 ) );
+					y = s - 1 - ( y & ( s - 1 ) );
+				}
+				unsigned int t = x;
+				x = y;
+				y = t;
+			}
+		}
+		return( d );
+	}
+
+	static inline int nextHalfedge( int e ){
+		return( e % 3 == 2 ? e - 2 : e + 1 );
+	}
+
+	/// incremental Bowyer-Watson triangulation. The hull is closed by ghost triangles with the
+	/// vertex index count standing for the point at infinity, so points outside the hull are
+	/// inserted like any other. vertex[ 3 * t ] < 0 marks a free triangle slot.
+	/// exact comparison, operator == allows MU_EPSILON
+	static bool sameVertex( const Vec2 & a, const Vec2 & b ){
+		return( a[ 0 ] == b[ 0 ] && a[ 1 ] == b[ 1 ] );
+	}
+
+	class DelaunayBuilder {
+		public:
+			DelaunayBuilder( const Vec2 * points, int count ) :
+				m_points( points ),
+				m_infinite( count ),
+				m_slot( count + 1, -1 ),
+				m_last( 0 ){
+			}
+
+			bool start( int a, int b, int c ){
+				double o = orient2d( m_points[ a ], m_points[ b ], m_points[ c ] );
+				if( o == 0.0 ){
+					return( false );
+				}
+				if( o < 0.0 ){
+					std::swap( b, c );
+				}
+				int t = addTriangle( a, b, c );
+				for( int k = 0; k < 3; k++ ){
+					int g = addTriangle( m_vertex[ nextHalfedge( 3 * t + k ) ], m_vertex[ 3 * t + k ], m_infinite );
+					link( 3 * t + k, 3 * g );
+					m_fan.push_back( g );
+				}
+				linkFan();
+				m_last = t;
+				return( true );
+			}
+
+			void insert( int p ){
+				int e = locate( p );
+				if( e < 0 ){
+					return;
+				}
+				// conflict region, its border edges and the triangle slots it frees
+				m_conflict.clear();
+				m_border.clear();
+				m_stack.clear();
+				m_stack.push_back( e / 3 );
+				m_mark[ e / 3 ] = true;
+				while( ! m_stack.empty() ){
+					int t = m_stack.back();
+					m_stack.pop_back();
+					m_conflict.push_back( t );
+					for( int k = 0; k < 3; k++ ){
+						int twin = m_halfedge[ 3 * t + k ];
+						int u = twin / 3;
+						if( m_mark[ u ] ){
+							continue;
+						}
+						if( conflicts( u, p ) ){
+							m_mark[ u ] = true;
+							m_stack.push_back( u );
+						}
+						else{
+							m_border.push_back( twin );
+						}
+					}
+				}
+				for( size_t i = 0; i < m_conflict.size(); i++ ){
+					m_mark[ m_conflict[ i ] ] = false;
+					m_vertex[ 3 * m_conflict[ i ] ] = -1;
+					m_free.push_back( m_conflict[ i ] );
+				}
+				// a fan from p to every border edge, seen from inside the region
+				for( size_t i = 0; i < m_border.size(); i++ ){
+					int outer = m_border[ i ];
+					int a = m_vertex[ nextHalfedge( outer ) ];
+					int b = m_vertex[ outer ];
+					int t = addTriangle( a, b, p );
+					link( 3 * t, outer );
+					m_fan.push_back( t );
+					if( a != m_infinite && b != m_infinite ){
+						m_last = t;
+					}
+				}
+				linkFan();
+			}
+
+			void output( std::vector< int > & triangles, std::vector< int > & halfedges ) const {
+				int triangleCount = ( int )m_vertex.size() / 3;
+				std::vector< int > index( triangleCount, -1 );
+				int count = 0;
+				for( int t = 0; t < triangleCount; t++ ){
+					if( finite( t ) ){
+						index[ t ] = count++;
+					}
+				}
+				triangles.resize( 3 * count );
+				halfedges.resize( 3 * count );
+				for( int t = 0; t < triangleCount; t++ ){
+					if( index[ t ] < 0 ){
+						continue;
+					}
+					for( int k = 0; k < 3; k++ ){
+						int twin = m_halfedge[ 3 * t + k ];
+						triangles[ 3 * index[ t ] + k ] = m_vertex[ 3 * t + k ];
+						halfedges[ 3 * index[ t ] + k ] = index[ twin / 3 ] < 0 ? -1 : 3 * index[ twin / 3 ] + twin % 3;
+					}
+				}
+			}
+
+		private:
+			int addTriangle( int a, int b, int c ){
+				int t;
+				if( m_free.empty() ){
+					t = ( int )m_vertex.size() / 3;
+					m_vertex.resize( 3 * t + 3 );
+					m_halfedge.resize( 3 * t + 3, -1 );
+					m_mark.push_back( false );
+				}
+				else{
+					t = m_free.back();
+					m_free.pop_back();
+				}
+				m_vertex[ 3 * t ] = a;
+				m_vertex[ 3 * t + 1 ] = b;
+				m_vertex[ 3 * t + 2 ] = c;
+				return( t );
+			}
+
+			void link( int a, int b ){
+				m_halfedge[ a ] = b;
+				m_halfedge[ b ] = a;
+			}
+
+			/// joins the side edges of the fan triangles ( a, b, apex ), the edge b apex of one
+			/// is shared with the triangle that starts at b
+			void linkFan( void ){
+				for( size_t i = 0; i < m_fan.size(); i++ ){
+					m_slot[ m_vertex[ 3 * m_fan[ i ] ] ] = m_fan[ i ];
+				}
+				for( size_t i = 0; i < m_fan.size(); i++ ){
+					int t = m_fan[ i ];
+					link( 3 * t + 1, 3 * m_slot[ m_vertex[ 3 * t + 1 ] ] + 2 );
+				}
+				for( size_t i = 0; i < m_fan.size(); i++ ){
+					m_slot[ m_vertex[ 3 * m_fan[ i ] ] ] = -1;
+				}
+				m_fan.clear();
+			}
+
+			bool finite( int t ) const {
+				return( m_vertex[ 3 * t ] >= 0 && m_vertex[ 3 * t ] != m_infinite && m_vertex[ 3 * t + 1 ] != m_infinite && m_vertex[ 3 * t + 2 ] != m_infinite );
+			}
+
+			/// the ghost ( u, v, infinity ) conflicts with points beyond its hull edge u v
+			bool conflicts( int t, int p ) const {
+				const int * v = & m_vertex[ 3 * t ];
+				for( int k = 0; k < 3; k++ ){
+					if( v[ k ] == m_infinite ){
+						const Vec2 & a = m_points[ v[ ( k + 1 ) % 3 ] ];
+						const Vec2 & b = m_points[ v[ ( k + 2 ) % 3 ] ];
+						const Vec2 & q = m_points[ p ];
+						double o = orient2d( a, b, q );
+						return( o > 0.0 || ( o == 0.0 && ( q - a ).dot( q - b ) < 0.0 ) );
+					}
+				}
+				return( incircle( m_points[ v[ 0 ] ], m_points[ v[ 1 ] ], m_points[ v[ 2 ] ], m_points[ p ] ) > 0.0 );
+			}
+
+			/// walks from the last finite triangle to one in conflict with p, returns one of
+			/// its half-edges or -1 when p repeats a vertex
+			int locate( int p ){
+				const Vec2 & q = m_points[ p ];
+				int t = m_last;
+				int rotation = 0;
+				for( ;; ){
+					int ghost = -1;
+					for( int k = 0; k < 3 && ghost < 0; k++ ){
+						ghost = m_vertex[ 3 * t + k ] == m_infinite ? k : -1;
+					}
+					if( ghost >= 0 ){
+						return( 3 * t );
+					}
+					int step = -1;
+					rotation = ( rotation + 1 ) % 3;
+					for( int i = 0; i < 3 && step < 0; i++ ){
+						int e = 3 * t + ( i + rotation ) % 3;
+						if( orient2d( m_points[ m_vertex[ e ] ], m_points[ m_vertex[ nextHalfedge( e ) ] ], q ) < 0.0 ){
+							step = e;
+						}
+					}
+					if( step < 0 ){
+						for( int k = 0; k < 3; k++ ){
+							if( sameVertex( m_points[ m_vertex[ 3 * t + k ] ], q ) ){
+								return( -1 );
+							}
+						}
+						return( 3 * t );
+					}
+					t = m_halfedge[ step ] / 3;
+				}
+			}
+
+			const Vec2 *            m_points;
+			int                     m_infinite;
+			std::vector< int >      m_vertex;
+			std::vector< int >      m_halfedge;
+			std::vector< bool >     m_mark;
+			std::vector< int >      m_free;
+			std::vector< int >      m_slot;
+			std::vector< int >      m_fan;
+			std::vector< int >      m_conflict;
+			std::vector< int >      m_border;
+			std::vector< int >      m_stack;
+			int                     m_last;
+	};
+
+	int delaunay( const Vec2 * points, int count, std::vector< int > & triangles, std::vector< int > & halfedges ){
+		triangles.clear();
+		halfedges.clear();
+		if( count < 3 ){
+			return( 0 );
+		}
+
+		// Hilbert order keeps consecutive points close, so the walks stay short
+		Vec2 boxMin = points[ 0 ], boxMax = points[ 0 ];
+		for( int i = 1; i < count; i++ ){
+			for( int j = 0; j < 2; j++ ){
+				boxMin[ j ] = points[ i ][ j ] < boxMin[ j ] ? points[ i ][ j ] : boxMin[ j ];
+				boxMax[ j ] = points[ i ][ j ] > boxMax[ j ] ? points[ i ][ j ] : boxMax[ j ];
+			}
+		}
+		double extent = largest( boxMax[ 0 ] - boxMin[ 0 ], boxMax[ 1 ] - boxMin[ 1 ] );
+		double scale = extent > 0.0 ? 65535.0 / extent : 0.0;
+		std::vector< uint64_t > codes( count );
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			codes[ i ] = hilbertDistance2( ( unsigned int )( ( points[ i ][ 0 ] - boxMin[ 0 ] ) * scale ), ( unsigned int )( ( points[ i ][ 1 ] - boxMin[ 1 ] ) * scale ) );
+		}
+		std::vector< int > order( count );
+		radixSort( & codes[ 0 ], count, & order[ 0 ] );
+
+		// the first triangle is the first point with the next two that span an area
+		int second = 1;
+		while( second < count && sameVertex( points[ order[ second ] ], points[ order[ 0 ] ] ) ){
+			second++;
+		}
+		int third = second + 1;
+		while( third < count && orient2d( points[ order[ 0 ] ], points[ order[ second ] ], points[ order[ third ] ] ) == 0.0 ){
+			third++;
+		}
+		if( third >= count ){
+			return( 0 );
+		}
+		DelaunayBuilder builder( points, count );
+		builder.start( order[ 0 ], order[ second ], order[ third ] );
+		for( int i = 1; i < count; i++ ){
+			if( i != second && i != third ){
+				builder.insert( order[ i ] );
+			}
+		}
+		builder.output( triangles, halfedges );
+		return( ( int )triangles.size() / 3 );
+	}
+
+	///--------------------------------polygons---------------------------
+
+	PolygonLocator::PolygonLocator( void ) :
+		m_minY( 0.0 ),
+		m_maxY( 0.0 ),
+		m_inverseSlabHeight( 0.0 ){
+	}
+
+	PolygonLocator::PolygonLocator( const Vec2 * vertices, int count, int slabCount ){
+		build( vertices, count, slabCount );
+	}
+
+	void PolygonLocator::build( const Vec2 * vertices, int count, int slabCount ){
+		int ringStarts[ 2 ] = { 0, count };
+		build( vertices, ringStarts, 1, slabCount );
+	}
+
+	/// one slab per edge by default. An edge is stored in every slab its y range touches, as
+	/// ( x0, y0, x1, y1 ) so a query reads its slab front to back.
+	void PolygonLocator::build( const Vec2 * vertices, const int * ringStarts, int ringCount, int slabCount ){
+		int edgeCount = ringStarts[ ringCount ] - ringStarts[ 0 ];
+		m_edges.clear();
+		m_slabStart.assign( 1, 0 );
+		m_minY = m_maxY = 0.0;
+		m_inverseSlabHeight = 0.0;
+		if( edgeCount <= 0 ){
+			return;
+		}
+		m_minY = m_maxY = vertices[ ringStarts[ 0 ] ][ 1 ];
+		for( int i = ringStarts[ 0 ]; i < ringStarts[ ringCount ]; i++ ){
+			m_minY = vertices[ i ][ 1 ] < m_minY ? vertices[ i ][ 1 ] : m_minY;
+			m_maxY = vertices[ i ][ 1 ] > m_maxY ? vertices[ i ][ 1 ] : m_maxY;
+		}
+		int slabs = slabCount > 0 ? slabCount : edgeCount;
+		m_inverseSlabHeight = m_maxY > m_minY ? slabs / ( m_maxY - m_minY ) : 0.0;
+		m_slabStart.assign( slabs + 1, 0 );
+
+		// count, scan, fill
+		for( int pass = 0; pass < 2; pass++ ){
+			std::vector< int > cursor;
+			if( pass ){
+				for( int i = 0; i < slabs; i++ ){
+					m_slabStart[ i + 1 ] += m_slabStart[ i ];
+				}
+				m_edges.resize( m_slabStart[ slabs ] );
+				cursor.assign( m_slabStart.begin(), m_slabStart.end() - 1 );
+			}
+			for( int r = 0; r < ringCount; r++ ){
+				int first = ringStarts[ r ], last = ringStarts[ r + 1 ];
+				for( int i = first; i < last; i++ ){
+					const Vec2 & a = vertices[ i ];
+					const Vec2 & b = vertices[ i + 1 < last ? i + 1 : first ];
+					if( a[ 1 ] == b[ 1 ] ){
+						continue;
+					}
+					int lo = ( int )( ( ( a[ 1 ] < b[ 1 ] ? a[ 1 ] : b[ 1 ] ) - m_minY ) * m_inverseSlabHeight );
+					int hi = ( int )( ( ( a[ 1 ] < b[ 1 ] ? b[ 1 ] : a[ 1 ] ) - m_minY ) * m_inverseSlabHeight );
+					hi = hi < slabs ? hi : slabs - 1;
+					for( int slab = lo; slab <= hi; slab++ ){
+						if( pass ){
+							m_edges[ cursor[ slab ]++ ] = Vec4( a[ 0 ], a[ 1 ], b[ 0 ], b[ 1 ] );
+						}
+						else{
+							m_slabStart[ slab + 1 ]++;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/// crossing number with half open edges, points on the upper boundary count as outside
+	bool PolygonLocator::contains( const Vec2 & point ) const {
+		double x = point[ 0 ], y = point[ 1 ];
+		if( m_edges.empty() || !( y >= m_minY && y < m_maxY ) ){
+			return( false );
+		}
+		int slabs = ( int )m_slabStart.size() - 1;
+		int slab = ( int )( ( y - m_minY ) * m_inverseSlabHeight );
+		slab = slab < slabs ? slab : slabs - 1;
+		bool inside = false;
+		for( int i = m_slabStart[ slab ]; i < m_slabStart[ slab + 1 ]; i++ ){
+			const Vec4 & e = m_edges[ i ];
+			if( ( e[ 1 ] > y ) != ( e[ 3 ] > y ) && x < e[ 0 ] + ( y - e[ 1 ] ) * ( e[ 2 ] - e[ 0 ] ) / ( e[ 3 ] - e[ 1 ] ) ){
+				inside = ! inside;
+			}
+		}
+		return( inside );
+	}
+
+	void PolygonLocator::contains( const Vec2 * points, int count, bool * inside ) const {
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			inside[ i ] = contains( points[ i ] );
+		}
+	}
+
+	void clipPolygon( const Vec2 * subject, int count, const Vec2 * convexClip, int clipCount, std::vector< Vec2 > & out ){
+		std::vector< Vec2 > input;
+		out.assign( subject, subject + count );
+		for( int j = 0; j < clipCount && ! out.empty(); j++ ){
+			const Vec2 & a = convexClip[ j ];
+			Vec2 edge = convexClip[ j + 1 < clipCount ? j + 1 : 0 ] - a;
+			input.swap( out );
+			out.clear();
+			Vec2 previous = input.back();
+			double previousSide = cross( edge, previous - a );
+			for( size_t i = 0; i < input.size(); i++ ){
+				const Vec2 & current = input[ i ];
+				double side = cross( edge, current - a );
+				if( ( side >= 0.0 ) != ( previousSide >= 0.0 ) ){
+					out.push_back( previous + ( current - previous ) * ( previousSide / ( previousSide - side ) ) );
+				}
+				if( side >= 0.0 ){
+					out.push_back( current );
+				}
+				previous = current;
+				previousSide = side;
+			}
+		}
+	}
+
+	void clipPolygon( const Vec2 * subject, int count, const Vec2 & boxMin, const Vec2 & boxMax, std::vector< Vec2 > & out ){
+		Vec2 box[ 4 ] = { boxMin, Vec2( boxMax[ 0 ], boxMin[ 1 ] ), boxMax, Vec2( boxMin[ 0 ], boxMax[ 1 ] ) };
+		clipPolygon( subject, count, box, 4, out );
+	}
+
+	static bool insideRing( const Vec2 * ring, int count, const Vec2 & p ){
+		bool inside = false;
+		for( int i = 0, j = count - 1; i < count; j = i++ ){
+			if( ( ring[ i ][ 1 ] > p[ 1 ] ) != ( ring[ j ][ 1 ] > p[ 1 ] ) &&
+				p[ 0 ] < ring[ i ][ 0 ] + ( p[ 1 ] - ring[ i ][ 1 ] ) * ( ring[ j ][ 0 ] - ring[ i ][ 0 ] ) / ( ring[ j ][ 1 ] - ring[ i ][ 1 ] ) ){
+				inside = ! inside;
+			}
+		}
+		return( inside );
+	}
+
+	/// vertex of one of the two linked rings, intersections are shared through neighbour
+	struct ClipNode {
+		Vec2 point;
+		int next;
+		int previous;
+		int neighbour;
+		double alpha;
+		bool intersection;
+		bool entry;
+		bool visited;
+	};
+
+	struct ClipCrossing {
+		int node;
+		double alpha;
+		bool operator < ( const ClipCrossing & b ) const {
+			return( alpha < b.alpha );
+		}
+	};
+
+	static ClipNode makeClipNode( const Vec2 & point, double alpha, bool intersection ){
+		ClipNode node;
+		node.point = point;
+		node.next = node.previous = node.neighbour = -1;
+		node.alpha = alpha;
+		node.intersection = intersection;
+		node.entry = false;
+		node.visited = false;
+		return( node );
+	}
+
+	/// links the ring of original vertices [ first, first + count ) with the crossings
+	/// found on each of its edges, in order along the edge
+	static void linkClipRing( std::vector< ClipNode > & nodes, int first, int count, std::vector< std::vector< ClipCrossing > > & crossings ){
+		int previous = first + count - 1;
+		for( int i = 0; i < count; i++ ){
+			std::vector< ClipCrossing > & edge = crossings[ previous - first ];
+			std::sort( edge.begin(), edge.end() );
+			int last = previous;
+			for( size_t k = 0; k < edge.size(); k++ ){
+				nodes[ last ].next = edge[ k ].node;
+				nodes[ edge[ k ].node ].previous = last;
+				last = edge[ k ].node;
+			}
+			nodes[ last ].next = first + i;
+			nodes[ first + i ].previous = last;
+			previous = first + i;
+		}
+	}
+
+	/// false when an edge pair touches in an endpoint or overlaps, the caller then perturbs.
+	/// Zero length edges cross nothing and are skipped
+	static bool buildClipRings( const Vec2 * subject, int count, const std::vector< Vec2 > & clip, std::vector< ClipNode > & nodes ){
+		int clipCount = ( int )clip.size();
+		nodes.clear();
+		for( int i = 0; i < count; i++ ){
+			nodes.push_back( makeClipNode( subject[ i ], 0.0, false ) );
+		}
+		for( int j = 0; j < clipCount; j++ ){
+			nodes.push_back( makeClipNode( clip[ j ], 0.0, false ) );
+		}
+		std::vector< std::vector< ClipCrossing > > subjectCrossings( count ), clipCrossings( clipCount );
+		for( int i = 0; i < count; i++ ){
+			const Vec2 & s0 = subject[ i ];
+			const Vec2 & s1 = subject[ i + 1 < count ? i + 1 : 0 ];
+			for( int j = 0; j < clipCount; j++ ){
+				const Vec2 & c0 = clip[ j ];
+				const Vec2 & c1 = clip[ j + 1 < clipCount ? j + 1 : 0 ];
+				if( sameVertex( s0, s1 ) || sameVertex( c0, c1 ) ){
+					continue;
+				}
+				double o0 = orient2d( c0, c1, s0 ), o1 = orient2d( c0, c1, s1 );
+				double o2 = orient2d( s0, s1, c0 ), o3 = orient2d( s0, s1, c1 );
+				if( ( o0 > 0.0 && o1 > 0.0 ) || ( o0 < 0.0 && o1 < 0.0 ) || ( o2 > 0.0 && o3 > 0.0 ) || ( o2 < 0.0 && o3 < 0.0 ) ){
+					continue;
+				}
+				if( o0 == 0.0 || o1 == 0.0 || o2 == 0.0 || o3 == 0.0 ){
+					return( false );
+				}
+				double t = o0 / ( o0 - o1 );
+				double u = o2 / ( o2 - o3 );
+				int a = ( int )nodes.size();
+				nodes.push_back( makeClipNode( s0 + ( s1 - s0 ) * t, t, true ) );
+				nodes.push_back( makeClipNode( nodes[ a ].point, u, true ) );
+				nodes[ a ].neighbour = a + 1;
+				nodes[ a + 1 ].neighbour = a;
+				ClipCrossing crossing;
+				crossing.node = a;
+				crossing.alpha = t;
+				subjectCrossings[ i ].push_back( crossing );
+				crossing.node = a + 1;
+				crossing.alpha = u;
+				clipCrossings[ j ].push_back( crossing );
+			}
+		}
+		linkClipRing( nodes, 0, count, subjectCrossings );
+		linkClipRing( nodes, count, clipCount, clipCrossings );
+		return( true );
+	}
+
+	static void markEntries( std::vector< ClipNode > & nodes, int first, bool inside, bool invert ){
+		bool entry = ! inside != invert;
+		int node = first;
+		do{
+			if( nodes[ node ].intersection ){
+				nodes[ node ].entry = entry;
+				entry = ! entry;
+			}
+			node = nodes[ node ].next;
+		}
+		while( node != first );
+	}
+
+	static std::vector< Vec2 > reversedRing( const Vec2 * ring, int count ){
+		std::vector< Vec2 > reversed( ring, ring + count );
+		std::reverse( reversed.begin(), reversed.end() );
+		return( reversed );
+	}
+
+	/// the ring without repeated consecutive vertices, including a last one equal to the first,
+	/// turned counterclockwise
+	static std::vector< Vec2 > counterclockwiseRing( const Vec2 * ring, int count ){
+		std::vector< Vec2 > kept;
+		for( int i = 0; i < count; i++ ){
+			if( kept.empty() || ! sameVertex( ring[ i ], kept.back() ) ){
+				kept.push_back( ring[ i ] );
+			}
+		}
+		while( kept.size() > 1 && sameVertex( kept.back(), kept.front() ) ){
+			kept.pop_back();
+		}
+		double area = 0.0;
+		for( size_t i = 0, j = kept.size() - 1; i < kept.size(); j = i++ ){
+			area += kept[ j ][ 0 ] * kept[ i ][ 1 ] - kept[ i ][ 0 ] * kept[ j ][ 1 ];
+		}
+		if( area < 0.0 ){
+			std::reverse( kept.begin(), kept.end() );
+		}
+		return( kept );
+	}
+
+	void clipPolygon( const Vec2 * subjectRing, int subjectCount, const Vec2 * clipRing, int clipRingCount, ClipOperation operation, std::vector< std::vector< Vec2 > > & out ){
+		out.clear();
+		std::vector< Vec2 > subjectKept = counterclockwiseRing( subjectRing, subjectCount );
+		std::vector< Vec2 > clipKept = counterclockwiseRing( clipRing, clipRingCount );
+		const Vec2 * subject = subjectKept.empty() ? 0 : & subjectKept[ 0 ];
+		const Vec2 * clip = clipKept.empty() ? 0 : & clipKept[ 0 ];
+		int count = ( int )subjectKept.size();
+		int clipCount = ( int )clipKept.size();
+		if( count < 3 || clipCount < 3 ){
+			if( operation != CLIP_INTERSECTION && count >= 3 ){
+				out.push_back( std::vector< Vec2 >( subject, subject + count ) );
+			}
+			if( operation == CLIP_UNION && clipCount >= 3 ){
+				out.push_back( std::vector< Vec2 >( clip, clip + clipCount ) );
+			}
+			return;
+		}
+
+		// shared vertices and overlapping edges are resolved by moving the clip polygon by
+		// a few ulps of the extent until all crossings are proper
+		Vec2 boxMin = subject[ 0 ], boxMax = subject[ 0 ];
+		for( int i = 0; i < count + clipCount; i++ ){
+			const Vec2 & p = i < count ? subject[ i ] : clip[ i - count ];
+			for( int j = 0; j < 2; j++ ){
+				boxMin[ j ] = p[ j ] < boxMin[ j ] ? p[ j ] : boxMin[ j ];
+				boxMax[ j ] = p[ j ] > boxMax[ j ] ? p[ j ] : boxMax[ j ];
+			}
+		}
+		double extent = largest( largest( boxMax[ 0 ] - boxMin[ 0 ], boxMax[ 1 ] - boxMin[ 1 ] ), largest( fabs( boxMax[ 0 ] ), fabs( boxMax[ 1 ] ) ) );
+		std::vector< Vec2 > moved( clip, clip + clipCount );
+		std::vector< ClipNode > nodes;
+		bool built = buildClipRings( subject, count, moved, nodes );
+		for( int attempt = 1; ! built && attempt < 16; attempt++ ){
+			double angle = attempt * 2.399963229728653;
+			Vec2 offset = Vec2( cos( angle ), sin( angle ) ) * ( extent * 1e-12 * attempt );
+			for( int j = 0; j < clipCount; j++ ){
+				moved[ j ] = clip[ j ] + offset;
+			}
+			built = buildClipRings( subject, count, moved, nodes );
+		}
+		if( ! built ){
+			EMIT_WARNING( __FILE__, __LINE__, "unresolved degenerate polygon intersection" );
+			return;
+		}
+		// the offset only decides the crossings, output rings carry the clip vertices as given
+		for( int j = 0; j < clipCount; j++ ){
+			nodes[ count + j ].point = clip[ j ];
+		}
+
+		bool subjectInClip = insideRing( & moved[ 0 ], clipCount, subject[ 0 ] );
+		bool clipInSubject = insideRing( subject, count, moved[ 0 ] );
+		if( ( int )nodes.size() == count + clipCount ){
+			// no crossings, one ring holds the other or they are disjoint
+			std::vector< Vec2 > s( subject, subject + count ), c( clip, clip + clipCount );
+			if( operation == CLIP_INTERSECTION ){
+				if( subjectInClip || clipInSubject ){
+					out.push_back( subjectInClip ? s : c );
+				}
+			}
+			else if( operation == CLIP_UNION ){
+				out.push_back( subjectInClip ? c : s );
+				if( ! subjectInClip && ! clipInSubject ){
+					out.push_back( c );
+				}
+			}
+			else if( ! subjectInClip ){
+				out.push_back( s );
+				if( clipInSubject ){
+					out.push_back( reversedRing( clip, clipCount ) );
+				}
+			}
+			return;
+		}
+
+		markEntries( nodes, 0, subjectInClip, operation != CLIP_INTERSECTION );
+		markEntries( nodes, count, clipInSubject, operation == CLIP_UNION );
+		// rings start where the subject is walked forward, so they all come out counterclockwise
+		for( size_t start = count + clipCount; start < nodes.size(); start += 2 ){
+			if( nodes[ start ].visited || ! nodes[ start ].entry ){
+				continue;
+			}
+			std::vector< Vec2 > ring;
+			int node = ( int )start;
+			ring.push_back( nodes[ node ].point );
+			do{
+				nodes[ node ].visited = nodes[ nodes[ node ].neighbour ].visited = true;
+				bool forward = nodes[ node ].entry;
+				do{
+					node = forward ? nodes[ node ].next : nodes[ node ].previous;
+					ring.push_back( nodes[ node ].point );
+				}
+				while( ! nodes[ node ].intersection );
+				node = nodes[ node ].neighbour;
+			}
+			while( ! nodes[ node ].visited );
+			ring.pop_back();
+			out.push_back( ring );
+		}
+	}
+
+	///--------------------------------geodesy----------------------------
+
+	static const double wgs84A = 6378137.0;
+	static const double wgs84F = 1.0 / 298.257223563;
+	static const double wgs84E2 = wgs84F * ( 2.0 - wgs84F );
+
+	Vec3 geodeticToEcef( const Vec3 & geodetic ){
+		double sinLatitude = sin( geodetic[ 0 ] ), cosLatitude = cos( geodetic[ 0 ] );
+		double sinLongitude = sin( geodetic[ 1 ] ), cosLongitude = cos( geodetic[ 1 ] );
+		double n = wgs84A / sqrt( 1.0 - wgs84E2 * sinLatitude * sinLatitude );
+		double r = ( n + geodetic[ 2 ] ) * cosLatitude;
+		return( Vec3( r * cosLongitude, r * sinLongitude, ( n * ( 1.0 - wgs84E2 ) + geodetic[ 2 ] ) * sinLatitude ) );
+	}
+
+	/// Bowring's parametric latitude iteration, converges from anywhere in a few steps
+	static double bowringLatitude( double p, double z ){
+		const double b = wgs84A * ( 1.0 - wgs84F );
+		const double ep2 = wgs84E2 / ( 1.0 - wgs84E2 );
+		double beta = atan2( z, ( 1.0 - wgs84F ) * p );
+		double latitude = 0.0;
+		for( int i = 0; i < 4; i++ ){
+			double sb = sin( beta ), cb = cos( beta );
+			latitude = atan2( z + ep2 * b * sb * sb * sb, p - wgs84E2 * wgs84A * cb * cb * cb );
+			beta = atan2( ( 1.0 - wgs84F ) * sin( latitude ), cos( latitude ) );
+		}
+		return( latitude );
+	}
+
+	Vec3 ecefToGeodetic( const Vec3 & ecef ){
+		const double e4 = wgs84E2 * wgs84E2;
+		double x = ecef[ 0 ], y = ecef[ 1 ], z = ecef[ 2 ];
+		double p2 = x * x + y * y;
+		double p = sqrt( p2 );
+		double longitude = atan2( y, x );
+		double latitude;
+		double pa = p2 / ( wgs84A * wgs84A );
+		double qa = ( 1.0 - wgs84E2 ) * z * z / ( wgs84A * wgs84A );
+		double r = ( pa + qa - e4 ) / 6.0;
+		double s = e4 * pa * qa / ( 4.0 * r * r * r );
+		if( r > 0.0 && s >= 0.0 ){
+			double t = pow( 1.0 + s + sqrt( s * ( 2.0 + s ) ), 1.0 / 3.0 );
+			double u = r * ( 1.0 + t + 1.0 / t );
+			double v = sqrt( u * u + e4 * qa );
+			double w = wgs84E2 * ( u + v - qa ) / ( 2.0 * v );
+			double k = sqrt( u + v + w * w ) - w;
+			double d = k * p / ( k + wgs84E2 );
+			double dz = sqrt( d * d + z * z );
+			latitude = 2.0 * atan2( z, d + dz );
+			return( Vec3( latitude, longitude, ( k + wgs84E2 - 1.0 ) / k * dz ) );
+		}
+		// within the evolute, some 40 km around the centre
+		latitude = bowringLatitude( p, z );
+		double sinLatitude = sin( latitude );
+		double n = wgs84A / sqrt( 1.0 - wgs84E2 * sinLatitude * sinLatitude );
+		return( Vec3( latitude, longitude, p * cos( latitude ) + z * sinLatitude - wgs84A * wgs84A / n ) );
+	}
+
+	/// columns east, north, up and the ECEF origin
+	Mat4 enuFrame( const Vec3 & geodetic ){
+		double sinLatitude = sin( geodetic[ 0 ] ), cosLatitude = cos( geodetic[ 0 ] );
+		double sinLongitude = sin( geodetic[ 1 ] ), cosLongitude = cos( geodetic[ 1 ] );
+		Vec3 origin = geodeticToEcef( geodetic );
+		return( Mat4(	-sinLongitude, cosLongitude, 0.0, 0.0,
+						-sinLatitude * cosLongitude, -sinLatitude * sinLongitude, cosLatitude, 0.0,
+						cosLatitude * cosLongitude, cosLatitude * sinLongitude, sinLatitude, 0.0,
+						origin[ 0 ], origin[ 1 ], origin[ 2 ], 1.0 ) );
+	}
+
+	void geodeticToEcef( const Vec3 * geodetic, int count, Vec3 * ecef ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			ecef[ i ] = geodeticToEcef( geodetic[ i ] );
+		}
+	}
+
+	void ecefToGeodetic( const Vec3 * ecef, int count, Vec3 * geodetic ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			geodetic[ i ] = ecefToGeodetic( ecef[ i ] );
+		}
+	}
+
+	void enuFrame( const Vec3 * geodetic, int count, Mat4 * frames ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			frames[ i ] = enuFrame( geodetic[ i ] );
+		}
+	}
+
+	///--------------------------------great circles----------------------
+
+	/// ( latitude, longitude ) against the ( azimuth, polar angle ) of Vec3::fromPolar
+	static Vec3 unitFromLatitudeLongitude( const Vec2 & position ){
+		return( Vec3::fromPolar( Vec2( position[ 1 ], M_PI_2 - position[ 0 ] ) ) );
+	}
+
+	/// directly rather than through toPolar, which zeroes the azimuth near the poles
+	static Vec2 latitudeLongitudeFromUnit( const Vec3 & unit ){
+		return( Vec2( asin( clamp( unit[ 2 ], -1.0, 1.0 ) ), atan2( unit[ 1 ], unit[ 0 ] ) ) );
+	}
+
+	/// haversine form, accurate for small and large separations alike
+	double greatCircleDistance( const Vec2 & a, const Vec2 & b ){
+		double sinLatitude = sin( 0.5 * ( b[ 0 ] - a[ 0 ] ) );
+		double sinLongitude = sin( 0.5 * ( b[ 1 ] - a[ 1 ] ) );
+		double h = sinLatitude * sinLatitude + cos( a[ 0 ] ) * cos( b[ 0 ] ) * sinLongitude * sinLongitude;
+		h = h < 1.0 ? h : 1.0;
+		return( 2.0 * atan2( sqrt( h ), sqrt( 1.0 - h ) ) );
+	}
+
+	double greatCircleDistance( const Vec3 & a, const Vec3 & b ){
+		return( atan2( sqrt( a.cross( b ).hyp() ), a.dot( b ) ) );
+	}
+
+	double initialBearing( const Vec2 & from, const Vec2 & to ){
+		double deltaLongitude = to[ 1 ] - from[ 1 ];
+		double cosTo = cos( to[ 0 ] );
+		return( atan2( sin( deltaLongitude ) * cosTo, cos( from[ 0 ] ) * sin( to[ 0 ] ) - sin( from[ 0 ] ) * cosTo * cos( deltaLongitude ) ) );
+	}
+
+	Vec2 greatCircleDestination( const Vec2 & from, double bearing, double distance ){
+		double sinFrom = sin( from[ 0 ] ), cosFrom = cos( from[ 0 ] );
+		double sinDistance = sin( distance ), cosDistance = cos( distance );
+		double sinLatitude = sinFrom * cosDistance + cosFrom * sinDistance * cos( bearing );
+		sinLatitude = clamp( sinLatitude, -1.0, 1.0 );
+		double longitude = from[ 1 ] + atan2( sin( bearing ) * sinDistance * cosFrom, cosDistance - sinFrom * sinLatitude );
+		return( Vec2( asin( sinLatitude ), remainder( longitude, 2.0 * M_PI ) ) );
+	}
+
+	Vec2 slerp( const Vec2 & a, const Vec2 & b, double t ){
+		return( latitudeLongitudeFromUnit( slerp( unitFromLatitudeLongitude( a ), unitFromLatitudeLongitude( b ), t ) ) );
+	}
+
+	Vec3 slerp( const Vec3 & a, const Vec3 & b, double t ){
+		double angle = greatCircleDistance( a, b );
+		double s = sin( angle );
+		if( s < 1e-9 && a.dot( b ) > 0.0 ){
+			// nearly equal, the chord is as good as the arc
+			return( normalize( a * ( 1.0 - t ) + b * t ) );
+		}
+		if( s < 1e-9 ){
+			// antipodal, turn toward the axis in which a is smallest
+			int axis = fabs( a[ 0 ] ) <= fabs( a[ 1 ] ) ? 0 : 1;
+			axis = fabs( a[ 2 ] ) < fabs( a[ axis ] ) ? 2 : axis;
+			Vec3 e( 0.0 );
+			e[ axis ] = 1.0;
+			Vec3 perpendicular = normalize( e - a * a.dot( e ) );
+			return( a * cos( t * angle ) + perpendicular * sin( t * angle ) );
+		}
+		return( ( a * sin( ( 1.0 - t ) * angle ) + b * sin( t * angle ) ) / s );
+	}
+
+	void greatCircleDistance( const Vec2 * a, const Vec2 * b, int count, double * distances ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			distances[ i ] = greatCircleDistance( a[ i ], b[ i ] );
+		}
+	}
+
+	void greatCircleDistance( const Vec3 * a, const Vec3 * b, int count, double * distances ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			distances[ i ] = greatCircleDistance( a[ i ], b[ i ] );
+		}
+	}
+
+	void initialBearing( const Vec2 * from, const Vec2 * to, int count, double * bearings ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			bearings[ i ] = initialBearing( from[ i ], to[ i ] );
+		}
+	}
+
+	void greatCircleDestination( const Vec2 * from, const double * bearings, const double * distances, int count, Vec2 * out ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			out[ i ] = greatCircleDestination( from[ i ], bearings[ i ], distances[ i ] );
+		}
+	}
+
+	void slerp( const Vec2 * a, const Vec2 * b, int count, double t, Vec2 * out ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			out[ i ] = slerp( a[ i ], b[ i ], t );
+		}
+	}
+
+	void slerp( const Vec3 * a, const Vec3 * b, int count, double t, Vec3 * out ){
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			out[ i ] = slerp( a[ i ], b[ i ], t );
+		}
+	}
+
+	///--------------------------------map projections--------------------
+
+	static const double utmScale = 0.9996;
+	static const double utmFalseEasting = 500000.0;
+	static const double webMercatorLatitude = 1.4844222297453324;	// atan( sinh( pi ) )
+
+	MapProjection::MapProjection( void ) :
+		m_type( WEB_MERCATOR ),
+		m_centralMeridian( 0.0 ),
+		m_parallelScale( 1.0 ),
+		m_falseNorthing( 0.0 ),
+		m_radius( wgs84A ),
+		m_tileSize( 256 ){
+		for( int j = 0; j < 6; j++ ){
+			m_alpha[ j ] = m_beta[ j ] = 0.0;
+		}
+	}
+
+	MapProjection MapProjection::webMercator( void ){
+		return( MapProjection() );
+	}
+
+	MapProjection MapProjection::equirectangular( double standardParallel, double centralMeridian ){
+		MapProjection projection;
+		projection.m_type = EQUIRECTANGULAR;
+		projection.m_parallelScale = cos( standardParallel );
+		projection.m_centralMeridian = centralMeridian;
+		return( projection );
+	}
+
+	/// the series coefficients depend on the ellipsoid only and are set up once here
+	MapProjection MapProjection::utm( int zone, bool south ){
+		MapProjection projection;
+		double n = wgs84F / ( 2.0 - wgs84F );
+		double n2 = n * n, n3 = n2 * n, n4 = n3 * n, n5 = n4 * n, n6 = n5 * n;
+		projection.m_type = UTM;
+		projection.m_centralMeridian = toRadians( zone * 6.0 - 183.0 );
+		projection.m_falseNorthing = south ? 10000000.0 : 0.0;
+		projection.m_radius = utmScale * wgs84A / ( 1.0 + n ) * ( 1.0 + n2 / 4.0 + n4 / 64.0 + n6 / 256.0 );
+		double * alpha = projection.m_alpha;
+		double * beta = projection.m_beta;
+		alpha[ 0 ] = n / 2.0 - 2.0 / 3.0 * n2 + 5.0 / 16.0 * n3 + 41.0 / 180.0 * n4 - 127.0 / 288.0 * n5 + 7891.0 / 37800.0 * n6;
+		alpha[ 1 ] = 13.0 / 48.0 * n2 - 3.0 / 5.0 * n3 + 557.0 / 1440.0 * n4 + 281.0 / 630.0 * n5 - 1983433.0 / 1935360.0 * n6;
+		alpha[ 2 ] = 61.0 / 240.0 * n3 - 103.0 / 140.0 * n4 + 15061.0 / 26880.0 * n5 + 167603.0 / 181440.0 * n6;
+		alpha[ 3 ] = 49561.0 / 161280.0 * n4 - 179.0 / 168.0 * n5 + 6601661.0 / 7257600.0 * n6;
+		alpha[ 4 ] = 34729.0 / 80640.0 * n5 - 3418889.0 / 1995840.0 * n6;
+		alpha[ 5 ] = 212378941.0 / 319334400.0 * n6;
+		beta[ 0 ] = n / 2.0 - 2.0 / 3.0 * n2 + 37.0 / 96.0 * n3 - 1.0 / 360.0 * n4 - 81.0 / 512.0 * n5 + 96199.0 / 604800.0 * n6;
+		beta[ 1 ] = 1.0 / 48.0 * n2 + 1.0 / 15.0 * n3 - 437.0 / 1440.0 * n4 + 46.0 / 105.0 * n5 - 1118711.0 / 3870720.0 * n6;
+		beta[ 2 ] = 17.0 / 480.0 * n3 - 37.0 / 840.0 * n4 - 209.0 / 4480.0 * n5 + 5569.0 / 90720.0 * n6;
+		beta[ 3 ] = 4397.0 / 161280.0 * n4 - 11.0 / 504.0 * n5 - 830251.0 / 7257600.0 * n6;
+		beta[ 4 ] = 4583.0 / 161280.0 * n5 - 108847.0 / 3991680.0 * n6;
+		beta[ 5 ] = 20648693.0 / 638668800.0 * n6;
+		return( projection );
+	}
+
+	int MapProjection::utmZone( const Vec2 & geodetic ){
+		int zone = ( int )floor( ( toDegrees( geodetic[ 1 ] ) + 180.0 ) / 6.0 ) % 60;
+		return( ( zone < 0 ? zone + 60 : zone ) + 1 );
+	}
+
+	MapProjection::Type MapProjection::type( void ) const {
+		return( m_type );
+	}
+
+	/// tan of the conformal latitude from tan of the geodetic latitude
+	static double conformalTangent( double tau ){
+		const double e = sqrt( wgs84E2 );
+		double root = sqrt( 1.0 + tau * tau );
+		double sigma = sinh( e * atanh( e * tau / root ) );
+		return( tau * sqrt( 1.0 + sigma * sigma ) - sigma * root );
+	}
+
+	Vec2 MapProjection::forward( const Vec2 & geodetic ) const {
+		double longitude = remainder( geodetic[ 1 ] - m_centralMeridian, 2.0 * M_PI );
+		if( m_type == WEB_MERCATOR ){
+			double latitude = clamp( geodetic[ 0 ], -webMercatorLatitude, webMercatorLatitude );
+			return( Vec2( m_radius * longitude, m_radius * asinh( tan( latitude ) ) ) );
+		}
+		if( m_type == EQUIRECTANGULAR ){
+			return( Vec2( m_radius * longitude * m_parallelScale, m_radius * geodetic[ 0 ] ) );
+		}
+		double tau = conformalTangent( tan( geodetic[ 0 ] ) );
+		double cosLongitude = cos( longitude );
+		double xi = atan2( tau, cosLongitude );
+		double eta = asinh( sin( longitude ) / sqrt( tau * tau + cosLongitude * cosLongitude ) );
+		double x = eta, y = xi;
+		for( int j = 0; j < 6; j++ ){
+			double k = 2.0 * ( j + 1 );
+			x += m_alpha[ j ] * cos( k * xi ) * sinh( k * eta );
+			y += m_alpha[ j ] * sin( k * xi ) * cosh( k * eta );
+		}
+		return( Vec2( utmFalseEasting + m_radius * x, m_falseNorthing + m_radius * y ) );
+	}
+
+	Vec2 MapProjection::inverse( const Vec2 & projected ) const {
+		if( m_type == WEB_MERCATOR ){
+			return( Vec2( atan( sinh( projected[ 1 ] / m_radius ) ), m_centralMeridian + projected[ 0 ] / m_radius ) );
+		}
+		if( m_type == EQUIRECTANGULAR ){
+			return( Vec2( projected[ 1 ] / m_radius, m_centralMeridian + projected[ 0 ] / ( m_radius * m_parallelScale ) ) );
+		}
+		double xi = ( projected[ 1 ] - m_falseNorthing ) / m_radius;
+		double eta = ( projected[ 0 ] - utmFalseEasting ) / m_radius;
+		double x = eta, y = xi;
+		for( int j = 0; j < 6; j++ ){
+			double k = 2.0 * ( j + 1 );
+			x -= m_beta[ j ] * cos( k * xi ) * sinh( k * eta );
+			y -= m_beta[ j ] * sin( k * xi ) * cosh( k * eta );
+		}
+		double sinhEta = sinh( x ), cosXi = cos( y );
+		double conformal = sin( y ) / sqrt( sinhEta * sinhEta + cosXi * cosXi );
+
+		// Newton on tau, Karney's update converges in two or three steps
+		double tau = conformal;
+		for( int i = 0; i < 5; i++ ){
+			double current = conformalTangent( tau );
+			double step = ( conformal - current ) / sqrt( 1.0 + current * current ) * ( 1.0 + ( 1.0 - wgs84E2 ) * tau * tau ) / ( ( 1.0 - wgs84E2 ) * sqrt( 1.0 + tau * tau ) );
+			tau += step;
+			if( fabs( step ) < 1e-15 * ( 1.0 + fabs( tau ) ) ){
+				break;
+			}
+		}
+		return( Vec2( atan( tau ), m_centralMeridian + atan2( sinhEta, cosXi ) ) );
+	}
+
+	void MapProjection::forward( const Vec2 * geodetic, int count, Vec2 * projected ) const {
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			projected[ i ] = forward( geodetic[ i ] );
+		}
+	}
+
+	void MapProjection::inverse( const Vec2 * projected, int count, Vec2 * geodetic ) const {
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			geodetic[ i ] = inverse( projected[ i ] );
+		}
+	}
+
+	void MapProjection::forward( const Vec3 * geodetic, int count, Vec3 * projected ) const {
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			Vec2 p = forward( Vec2( geodetic[ i ][ 0 ], geodetic[ i ][ 1 ] ) );
+			projected[ i ] = Vec3( p[ 0 ], p[ 1 ], geodetic[ i ][ 2 ] );
+		}
+	}
+
+	void MapProjection::inverse( const Vec3 * projected, int count, Vec3 * geodetic ) const {
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			Vec2 g = inverse( Vec2( projected[ i ][ 0 ], projected[ i ][ 1 ] ) );
+			geodetic[ i ] = Vec3( g[ 0 ], g[ 1 ], projected[ i ][ 2 ] );
+		}
+	}
+
+	/// drops the cached tiles, their constants depend on the size
+	void MapProjection::setTileSize( int pixels ){
+		m_tileSize = pixels;
+		m_tiles.clear();
+	}
+
+	const MapProjection::Tile & MapProjection::tile( int zoom, int x, int y ) const {
+		uint64_t key = ( ( uint64_t )zoom << 58 ) | ( ( uint64_t )x << 29 ) | ( uint64_t )y;
+		std::map< uint64_t, Tile >::iterator found = m_tiles.find( key );
+		if( found != m_tiles.end() ){
+			return( found->second );
+		}
+		double extent = M_PI * wgs84A;
+		Tile & t = m_tiles[ key ];
+		t.zoom = zoom;
+		t.x = x;
+		t.y = y;
+		t.scale = m_tileSize * ldexp( 1.0, zoom ) / ( 2.0 * extent );
+		t.origin = Vec2( -extent + x * m_tileSize / t.scale, extent - y * m_tileSize / t.scale );
+		t.matrix = Mat4(	t.scale, 0.0, 0.0, 0.0,
+							0.0, -t.scale, 0.0, 0.0,
+							0.0, 0.0, 1.0, 0.0,
+							-t.origin[ 0 ] * t.scale, t.origin[ 1 ] * t.scale, 0.0, 1.0 );
+		return( t );
+	}
+
+	/// projection and tile transform in one pass
+	void MapProjection::forward( const Tile & tile, const Vec2 * geodetic, int count, Vec2 * pixels ) const {
+		const double scale = tile.scale, x0 = tile.origin[ 0 ], y0 = tile.origin[ 1 ];
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			Vec2 p = forward( geodetic[ i ] );
+			pixels[ i ] = Vec2( ( p[ 0 ] - x0 ) * scale, ( y0 - p[ 1 ] ) * scale );
+		}
+	}
+
+	///--------------------------------splines----------------------------
+
+	/// segment index and local parameter of t over segments unit segments, clamped to the ends
+	static int splineSegment( double t, int segments, double & u ){
+		if( !( t > 0.0 ) ){
+			u = 0.0;
+			return( 0 );
+		}
+		if( t >= segments ){
+			u = 1.0;
+			return( segments - 1 );
+		}
+		int i = ( int )t;
+		u = t - i;
+		return( i );
+	}
+
+	/// samples [ begin, end ) of count evenly spaced parameters over [ 0, segments ] that fall
+	/// into the segment, the last segment also takes the end point
+	static void uniformSampleRange( int segment, int segments, int count, int & begin, int & end ){
+		long long intervals = count - 1;
+		begin = ( int )( ( segment * intervals + segments - 1 ) / segments );
+		end = segment == segments - 1 ? count : ( int )( ( ( segment + 1 ) * intervals + segments - 1 ) / segments );
+	}
+
+	/// inverts a cumulative length table over evenly spaced parameters into the parameters at
+	/// evenly spaced distances, the table keeps its number of entries
+	static void resampleByDistance( const std::vector< double > & cumulative, double parameterStep, std::vector< double > & parameters ){
+		int m = ( int )cumulative.size();
+		double total = cumulative[ m - 1 ];
+		parameters.resize( m );
+		int k = 0;
+		for( int j = 0; j < m; j++ ){
+			double target = total * j / ( m - 1 );
+			while( k < m - 2 && cumulative[ k + 1 ] < target ){
+				k++;
+			}
+			double span = cumulative[ k + 1 ] - cumulative[ k ];
+			double f = span > 0.0 ? clamp( ( target - cumulative[ k ] ) / span, 0.0, 1.0 ) : 0.0;
+			parameters[ j ] = ( k + f ) * parameterStep;
+		}
+	}
+
+	static double arcParameter( const std::vector< double > & parameters, double length, double distance ){
+		int m = ( int )parameters.size();
+		if( m < 2 || !( length > 0.0 ) ){
+			return( 0.0 );
+		}
+		double x = clamp( distance / length, 0.0, 1.0 ) * ( m - 1 );
+		int j = ( int )x;
+		if( j > m - 2 ){
+			j = m - 2;
+		}
+		double f = x - j;
+		return( parameters[ j ] * ( 1.0 - f ) + parameters[ j + 1 ] * f );
+	}
+
+	template< class T >
+	static T cubicValue( const T * c, double u ){
+		return( c[ 0 ] + ( c[ 1 ] + ( c[ 2 ] + c[ 3 ] * u ) * u ) * u );
+	}
+
+	template< class T >
+	static T cubicDerivative( const T * c, double u ){
+		return( c[ 1 ] + ( c[ 2 ] * 2.0 + c[ 3 ] * ( 3.0 * u ) ) * u );
+	}
+
+	/// power basis a + b u + c u^2 + d u^3 of the segment between p1 and p2
+	template< class T >
+	static void catmullRomSegment( const T & p0, const T & p1, const T & p2, const T & p3, T * c ){
+		c[ 0 ] = p1;
+		c[ 1 ] = ( p2 - p0 ) * 0.5;
+		c[ 2 ] = p0 - p1 * 2.5 + p2 * 2.0 - p3 * 0.5;
+		c[ 3 ] = ( p3 - p0 + ( p1 - p2 ) * 3.0 ) * 0.5;
+	}
+
+	template< class T >
+	CubicSpline< T >::CubicSpline( void ) :
+		m_length( 0.0 ){
+	}
+
+	template< class T >
+	CubicSpline< T > CubicSpline< T >::catmullRom( const T * points, int count ){
+		CubicSpline spline;
+		if( count == 1 ){
+			spline.m_coefficients.resize( 4, T( 0.0 ) );
+			spline.m_coefficients[ 0 ] = points[ 0 ];
+		}
+		if( count < 2 ){
+			return( spline );
+		}
+		spline.m_coefficients.resize( 4 * ( count - 1 ) );
+		T first = points[ 0 ] * 2.0 - points[ 1 ];
+		T last = points[ count - 1 ] * 2.0 - points[ count - 2 ];
+		for( int i = 0; i < count - 1; i++ ){
+			catmullRomSegment(	i > 0 ? points[ i - 1 ] : first, points[ i ], points[ i + 1 ],
+								i + 2 < count ? points[ i + 2 ] : last, & spline.m_coefficients[ 4 * i ] );
+		}
+		return( spline );
+	}
+
+	/// trailing control points that do not complete a segment are ignored
+	template< class T >
+	CubicSpline< T > CubicSpline< T >::bezier( const T * controlPoints, int count ){
+		CubicSpline spline;
+		int segments = count > 0 ? ( count - 1 ) / 3 : 0;
+		spline.m_coefficients.resize( 4 * segments );
+		for( int i = 0; i < segments; i++ ){
+			const T * p = controlPoints + 3 * i;
+			T * c = & spline.m_coefficients[ 4 * i ];
+			c[ 0 ] = p[ 0 ];
+			c[ 1 ] = ( p[ 1 ] - p[ 0 ] ) * 3.0;
+			c[ 2 ] = ( p[ 0 ] - p[ 1 ] * 2.0 + p[ 2 ] ) * 3.0;
+			c[ 3 ] = p[ 3 ] - p[ 0 ] + ( p[ 1 ] - p[ 2 ] ) * 3.0;
+		}
+		return( spline );
+	}
+
+	/// count - 3 segments, fewer than four control points give an empty curve
+	template< class T >
+	CubicSpline< T > CubicSpline< T >::bSpline( const T * controlPoints, int count ){
+		CubicSpline spline;
+		int segments = count > 3 ? count - 3 : 0;
+		spline.m_coefficients.resize( 4 * segments );
+		for( int i = 0; i < segments; i++ ){
+			const T * p = controlPoints + i;
+			T * c = & spline.m_coefficients[ 4 * i ];
+			c[ 0 ] = ( p[ 0 ] + p[ 1 ] * 4.0 + p[ 2 ] ) * ( 1.0 / 6.0 );
+			c[ 1 ] = ( p[ 2 ] - p[ 0 ] ) * 0.5;
+			c[ 2 ] = ( p[ 0 ] - p[ 1 ] * 2.0 + p[ 2 ] ) * 0.5;
+			c[ 3 ] = ( p[ 3 ] - p[ 0 ] + ( p[ 1 ] - p[ 2 ] ) * 3.0 ) * ( 1.0 / 6.0 );
+		}
+		return( spline );
+	}
+
+	template< class T >
+	int CubicSpline< T >::segmentCount( void ) const {
+		return( ( int )m_coefficients.size() / 4 );
+	}
+
+	template< class T >
+	T CubicSpline< T >::evaluate( double t ) const {
+		int segments = segmentCount();
+		if( segments == 0 ){
+			return( T( 0.0 ) );
+		}
+		double u;
+		int i = splineSegment( t, segments, u );
+		return( cubicValue( & m_coefficients[ 4 * i ], u ) );
+	}
+
+	template< class T >
+	T CubicSpline< T >::derivative( double t ) const {
+		int segments = segmentCount();
+		if( segments == 0 ){
+			return( T( 0.0 ) );
+		}
+		double u;
+		int i = splineSegment( t, segments, u );
+		return( cubicDerivative( & m_coefficients[ 4 * i ], u ) );
+	}
+
+	template< class T >
+	void CubicSpline< T >::evaluate( const double * parameters, int count, T * out ) const {
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			out[ i ] = evaluate( parameters[ i ] );
+		}
+	}
+
+	/// forward differences restart at every segment, so the rounding drift stays within one
+	/// segment and the segments run in parallel
+	template< class T >
+	void CubicSpline< T >::sampleUniform( int count, T * out ) const {
+		int segments = segmentCount();
+		if( count < 2 || segments == 0 ){
+			for( int i = 0; i < count; i++ ){
+				out[ i ] = evaluate( 0.0 );
+			}
+			return;
+		}
+		const double h = ( double )segments / ( count - 1 );
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int s = 0; s < segments; s++ ){
+			int begin, end;
+			uniformSampleRange( s, segments, count, begin, end );
+			if( begin >= end ){
+				continue;
+			}
+			const T * c = & m_coefficients[ 4 * s ];
+			double u = begin * h - s;
+			T p = cubicValue( c, u );
+			T d1 = c[ 1 ] * h + c[ 2 ] * ( ( 2.0 * u + h ) * h ) + c[ 3 ] * ( ( ( 3.0 * u + 3.0 * h ) * u + h * h ) * h );
+			T d2 = c[ 2 ] * ( 2.0 * h * h ) + c[ 3 ] * ( 6.0 * ( u + h ) * h * h );
+			T d3 = c[ 3 ] * ( 6.0 * h * h * h );
+			for( int i = begin; i < end; i++ ){
+				out[ i ] = p;
+				p += d1;
+				d1 += d2;
+				d2 += d3;
+			}
+		}
+		out[ count - 1 ] = evaluate( segments );
+	}
+
+	/// lengths between the table samples integrate the speed with three point Gauss-Legendre,
+	/// through length2 since len() rounds short vectors down to zero
+	template< class T >
+	void CubicSpline< T >::buildArcLengthTable( int samplesPerSegment ){
+		int segments = segmentCount();
+		m_arcParameters.clear();
+		m_length = 0.0;
+		if( segments == 0 || samplesPerSegment < 1 ){
+			return;
+		}
+		int intervals = segments * samplesPerSegment;
+		const double h = 1.0 / samplesPerSegment;
+		const double node = 0.5 * h * sqrt( 0.6 );
+		std::vector< double > cumulative( intervals + 1 );
+		cumulative[ 0 ] = 0.0;
+		MU_PRAGMA( omp parallel for schedule( static ) if( intervals > MU_PARALLEL_GRAIN ) )
+		for( int k = 0; k < intervals; k++ ){
+			const T * c = & m_coefficients[ 4 * ( k / samplesPerSegment ) ];
+			double u = ( k % samplesPerSegment + 0.5 ) * h;
+			cumulative[ k + 1 ] = 0.5 * h * (	( 8.0 / 9.0 ) * sqrt( length2( cubicDerivative( c, u ) ) ) +
+												( 5.0 / 9.0 ) * ( sqrt( length2( cubicDerivative( c, u - node ) ) ) +
+																  sqrt( length2( cubicDerivative( c, u + node ) ) ) ) );
+		}
+		for( int k = 0; k < intervals; k++ ){
+			cumulative[ k + 1 ] += cumulative[ k ];
+		}
+		m_length = cumulative[ intervals ];
+		resampleByDistance( cumulative, h, m_arcParameters );
+	}
+
+	template< class T >
+	double CubicSpline< T >::length( void ) const {
+		return( m_length );
+	}
+
+	template< class T >
+	double CubicSpline< T >::parameterAtDistance( double distance ) const {
+		return( arcParameter( m_arcParameters, m_length, distance ) );
+	}
+
+	template< class T >
+	T CubicSpline< T >::evaluateAtDistance( double distance ) const {
+		return( evaluate( parameterAtDistance( distance ) ) );
+	}
+
+	template< class T >
+	void CubicSpline< T >::evaluateAtDistance( const double * distances, int count, T * out ) const {
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			out[ i ] = evaluate( parameterAtDistance( distances[ i ] ) );
+		}
+	}
+
+	template class CubicSpline< Vec2 >;
+	template class CubicSpline< Vec3 >;
+	template class CubicSpline< Vec4 >;
+
+	/// Hamilton product, log and exp of unit quaternions with w in the last component as in
+	/// toMat3
+	static Quat unitProduct( const Quat & a, const Quat & b ){
+		return( Quat(	a[ 3 ] * b[ 0 ] + a[ 0 ] * b[ 3 ] + a[ 1 ] * b[ 2 ] - a[ 2 ] * b[ 1 ],
+						a[ 3 ] * b[ 1 ] - a[ 0 ] * b[ 2 ] + a[ 1 ] * b[ 3 ] + a[ 2 ] * b[ 0 ],
+						a[ 3 ] * b[ 2 ] + a[ 0 ] * b[ 1 ] - a[ 1 ] * b[ 0 ] + a[ 2 ] * b[ 3 ],
+						a[ 3 ] * b[ 3 ] - a[ 0 ] * b[ 0 ] - a[ 1 ] * b[ 1 ] - a[ 2 ] * b[ 2 ] ) );
+	}
+
+	static Quat unitConjugate( const Quat & q ){
+		return( Quat( -q[ 0 ], -q[ 1 ], -q[ 2 ], q[ 3 ] ) );
+	}
+
+	static Vec3 unitLog( const Quat & q ){
+		Vec3 v( q[ 0 ], q[ 1 ], q[ 2 ] );
+		double s = sqrt( v.hyp() );
+		return( s > 0.0 ? v * ( atan2( s, q[ 3 ] ) / s ) : v );
+	}
+
+	static Quat unitExp( const Vec3 & v ){
+		double a = sqrt( v.hyp() );
+		double k = a > 0.0 ? sin( a ) / a : 1.0;
+		return( Quat( v[ 0 ] * k, v[ 1 ] * k, v[ 2 ] * k, cos( a ) ) );
+	}
+
+	/// angle between unit quaternions as 4d vectors, half the rotation angle between them
+	static double unitAngle( const Quat & a, const Quat & b ){
+		return( 2.0 * atan2( ( a - b ).len(), ( a + b ).len() ) );
+	}
+
+	/// slerp along the arc from a to b without hemisphere correction, angle from unitAngle
+	static Quat unitSlerp( const Quat & a, const Quat & b, double h, double angle ){
+		if( angle < 1e-6 ){
+			Quat q = a * ( 1.0 - h ) + b * h;
+			return( q / q.len() );
+		}
+		double s = 1.0 / sin( angle );
+		return( a * ( sin( ( 1.0 - h ) * angle ) * s ) + b * ( sin( h * angle ) * s ) );
+	}
+
+	Squad::Squad( void ) :
+		m_length( 0.0 ){
+	}
+
+	Squad::Squad( const Quat * keys, int count ) :
+		m_length( 0.0 ){
+		setKeys( keys, count );
+	}
+
+	/// inner control s_i = q_i exp( -( log( q_i^-1 q_i+1 ) + log( q_i^-1 q_i-1 ) ) / 4 ), the
+	/// end keys are their own controls
+	void Squad::setKeys( const Quat * keys, int count ){
+		m_keys.resize( count );
+		m_controls.resize( count );
+		m_arcParameters.clear();
+		m_length = 0.0;
+		for( int i = 0; i < count; i++ ){
+			m_keys[ i ] = keys[ i ].normalized();
+			if( i > 0 && m_keys[ i ].dot( m_keys[ i - 1 ] ) < 0.0 ){
+				m_keys[ i ] = -m_keys[ i ];
+			}
+		}
+		for( int i = 0; i < count; i++ ){
+			if( i == 0 || i == count - 1 ){
+				m_controls[ i ] = m_keys[ i ];
+				continue;
+			}
+			Quat inverse = unitConjugate( m_keys[ i ] );
+			Vec3 tangent = unitLog( unitProduct( inverse, m_keys[ i + 1 ] ) ) + unitLog( unitProduct( inverse, m_keys[ i - 1 ] ) );
+			m_controls[ i ] = unitProduct( m_keys[ i ], unitExp( tangent * -0.25 ) );
+		}
+		int segments = segmentCount();
+		m_keyAngles.resize( segments );
+		m_controlAngles.resize( segments );
+		for( int i = 0; i < segments; i++ ){
+			m_keyAngles[ i ] = unitAngle( m_keys[ i ], m_keys[ i + 1 ] );
+			m_controlAngles[ i ] = unitAngle( m_controls[ i ], m_controls[ i + 1 ] );
+		}
+	}
+
+	int Squad::segmentCount( void ) const {
+		return( m_keys.size() > 1 ? ( int )m_keys.size() - 1 : 0 );
+	}
+
+	Quat Squad::evaluateSegment( int segment, double h ) const {
+		Quat a = unitSlerp( m_keys[ segment ], m_keys[ segment + 1 ], h, m_keyAngles[ segment ] );
+		Quat b = unitSlerp( m_controls[ segment ], m_controls[ segment + 1 ], h, m_controlAngles[ segment ] );
+		return( unitSlerp( a, b, 2.0 * h * ( 1.0 - h ), unitAngle( a, b ) ) );
+	}
+
+	Quat Squad::evaluate( double t ) const {
+		if( m_keys.empty() ){
+			return( Quat( 0.0, 0.0, 0.0, 1.0 ) );
+		}
+		int segments = segmentCount();
+		if( segments == 0 ){
+			return( m_keys[ 0 ] );
+		}
+		double h;
+		int i = splineSegment( t, segments, h );
+		return( evaluateSegment( i, h ) );
+	}
+
+	void Squad::evaluate( const double * parameters, int count, Quat * out ) const {
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			out[ i ] = evaluate( parameters[ i ] );
+		}
+	}
+
+	/// walks the samples segment by segment, skipping the search for the segment
+	void Squad::sampleUniform( int count, Quat * out ) const {
+		int segments = segmentCount();
+		if( count < 2 || segments == 0 ){
+			for( int i = 0; i < count; i++ ){
+				out[ i ] = evaluate( 0.0 );
+			}
+			return;
+		}
+		const double h = ( double )segments / ( count - 1 );
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int s = 0; s < segments; s++ ){
+			int begin, end;
+			uniformSampleRange( s, segments, count, begin, end );
+			for( int i = begin; i < end; i++ ){
+				out[ i ] = evaluateSegment( s, clamp( i * h - s, 0.0, 1.0 ) );
+			}
+		}
+	}
+
+	/// rotation angles between consecutive table samples, the chords of the rotation path
+	void Squad::buildArcLengthTable( int samplesPerSegment ){
+		int segments = segmentCount();
+		m_arcParameters.clear();
+		m_length = 0.0;
+		if( segments == 0 || samplesPerSegment < 1 ){
+			return;
+		}
+		int intervals = segments * samplesPerSegment;
+		std::vector< Quat > samples( intervals + 1 );
+		sampleUniform( intervals + 1, & samples[ 0 ] );
+		std::vector< double > cumulative( intervals + 1 );
+		cumulative[ 0 ] = 0.0;
+		for( int k = 0; k < intervals; k++ ){
+			const Quat & a = samples[ k ];
+			const Quat & b = a.dot( samples[ k + 1 ] ) < 0.0 ? -samples[ k + 1 ] : samples[ k + 1 ];
+			cumulative[ k + 1 ] = cumulative[ k ] + 2.0 * unitAngle( a, b );
+		}
+		m_length = cumulative[ intervals ];
+		resampleByDistance( cumulative, 1.0 / samplesPerSegment, m_arcParameters );
+	}
+
+	double Squad::length( void ) const {
+		return( m_length );
+	}
+
+	double Squad::parameterAtDistance( double distance ) const {
+		return( arcParameter( m_arcParameters, m_length, distance ) );
+	}
+
+	Quat Squad::evaluateAtDistance( double distance ) const {
+		return( evaluate( parameterAtDistance( distance ) ) );
+	}
+
+	void Squad::evaluateAtDistance( const double * distances, int count, Quat * out ) const {
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			out[ i ] = evaluate( parameterAtDistance( distances[ i ] ) );
+		}
+	}
+
+	///--------------------------------animation tracks-------------------
+
+	/// segment of the key times holding time, tried at the hint and its neighbours before the
+	/// binary search
+	template< class R >
+	static int keySegment( const R * times, int count, double time, int hint ){
+		int last = count - 2;
+		if( last <= 0 ){
+			return( 0 );
+		}
+		if( hint < 0 || hint > last ){
+			hint = 0;
+		}
+		if( time >= times[ hint ] ){
+			if( hint == last || time < times[ hint + 1 ] ){
+				return( hint );
+			}
+			if( hint + 1 == last || time < times[ hint + 2 ] ){
+				return( hint + 1 );
+			}
+		}
+		else if( hint == 0 || time >= times[ hint - 1 ] ){
+			return( hint > 0 ? hint - 1 : 0 );
+		}
+		int segment = ( int )( std::upper_bound( times, times + count, time ) - times ) - 1;
+		return( segment < 0 ? 0 : segment > last ? last : segment );
+	}
+
+	/// key indices a and b around time in the track and the blend weight between them, the
+	/// segment is the cursor's hint and comes back updated
+	template< class R >
+	static double trackBlend( const R * times, const int * offsets, int track, double time, int & segment, int & a, int & b ){
+		int first = offsets[ track ];
+		int count = offsets[ track + 1 ] - first;
+		segment = keySegment( times + first, count, time, segment );
+		a = first + segment;
+		if( count < 2 ){
+			b = a;
+			return( 0.0 );
+		}
+		b = a + 1;
+		double span = times[ b ] - times[ a ];
+		if( !( span > 0.0 ) ){
+			return( time >= times[ b ] ? 1.0 : 0.0 );
+		}
+		return( clamp( ( time - times[ a ] ) / span, 0.0, 1.0 ) );
+	}
+
+	AnimationTracks::AnimationTracks( void ) :
+		m_vec3Offsets( 1, 0 ),
+		m_quatOffsets( 1, 0 ){
+	}
+
+	/// returns the track index, or -1 for a track without keys
+	int AnimationTracks::addTrack( const double * times, const Vec3 * keys, int count ){
+		if( count < 1 ){
+			return( -1 );
+		}
+		for( int i = 0; i < count; i++ ){
+			m_vec3Times.push_back( times[ i ] );
+			for( int c = 0; c < 3; c++ ){
+				m_vec3Keys[ c ].push_back( keys[ i ][ c ] );
+			}
+		}
+		m_vec3Offsets.push_back( ( int )m_vec3Times.size() );
+		return( vec3TrackCount() - 1 );
+	}
+
+	int AnimationTracks::addTrack( const double * times, const Quat * keys, int count ){
+		if( count < 1 ){
+			return( -1 );
+		}
+		Quat previous;
+		for( int i = 0; i < count; i++ ){
+			Quat q = keys[ i ].normalized();
+			if( i > 0 && q.dot( previous ) < 0.0 ){
+				q = -q;
+			}
+			m_quatTimes.push_back( times[ i ] );
+			for( int c = 0; c < 4; c++ ){
+				m_quatKeys[ c ].push_back( q[ c ] );
+			}
+			previous = q;
+		}
+		m_quatOffsets.push_back( ( int )m_quatTimes.size() );
+		return( quatTrackCount() - 1 );
+	}
+
+	int AnimationTracks::vec3TrackCount( void ) const {
+		return( ( int )m_vec3Offsets.size() - 1 );
+	}
+
+	int AnimationTracks::quatTrackCount( void ) const {
+		return( ( int )m_quatOffsets.size() - 1 );
+	}
+
+	double AnimationTracks::startTime( void ) const {
+		double start = HUGE_VAL;
+		for( int t = 0; t < vec3TrackCount(); t++ ){
+			start = smallest( start, m_vec3Times[ m_vec3Offsets[ t ] ] );
+		}
+		for( int t = 0; t < quatTrackCount(); t++ ){
+			start = smallest( start, m_quatTimes[ m_quatOffsets[ t ] ] );
+		}
+		return( start == HUGE_VAL ? 0.0 : start );
+	}
+
+	double AnimationTracks::endTime( void ) const {
+		double end = -HUGE_VAL;
+		for( int t = 0; t < vec3TrackCount(); t++ ){
+			end = largest( end, m_vec3Times[ m_vec3Offsets[ t + 1 ] - 1 ] );
+		}
+		for( int t = 0; t < quatTrackCount(); t++ ){
+			end = largest( end, m_quatTimes[ m_quatOffsets[ t + 1 ] - 1 ] );
+		}
+		return( end == -HUGE_VAL ? 0.0 : end );
+	}
+
+	Vec3 AnimationTracks::sampleVec3( int track, double time, Cursor & cursor ) const {
+		if( ( int )cursor.vec3Segments.size() < vec3TrackCount() ){
+			cursor.vec3Segments.resize( vec3TrackCount(), 0 );
+		}
+		int a, b;
+		double f = trackBlend( & m_vec3Times[ 0 ], & m_vec3Offsets[ 0 ], track, time, cursor.vec3Segments[ track ], a, b );
+		Vec3 v;
+		for( int c = 0; c < 3; c++ ){
+			v[ c ] = m_vec3Keys[ c ][ a ] + ( m_vec3Keys[ c ][ b ] - m_vec3Keys[ c ][ a ] ) * f;
+		}
+		return( v );
+	}
+
+	Quat AnimationTracks::sampleQuat( int track, double time, Cursor & cursor ) const {
+		if( ( int )cursor.quatSegments.size() < quatTrackCount() ){
+			cursor.quatSegments.resize( quatTrackCount(), 0 );
+		}
+		int a, b;
+		double f = trackBlend( & m_quatTimes[ 0 ], & m_quatOffsets[ 0 ], track, time, cursor.quatSegments[ track ], a, b );
+		Quat q;
+		for( int c = 0; c < 4; c++ ){
+			q[ c ] = m_quatKeys[ c ][ a ] + ( m_quatKeys[ c ][ b ] - m_quatKeys[ c ][ a ] ) * f;
+		}
+		return( q / q.len() );
+	}
+
+	/// every track at one time, packets of MU_PACKET_SIZE tracks find their segments and then
+	/// blend component by component across the lanes. Either output may be null to skip that
+	/// kind of track
+	void AnimationTracks::sample( double time, Cursor & cursor, Vec3 * vec3Values, Quat * quatValues ) const {
+		int vec3Tracks = vec3TrackCount();
+		int quatTracks = quatTrackCount();
+		if( ( int )cursor.vec3Segments.size() < vec3Tracks ){
+			cursor.vec3Segments.resize( vec3Tracks, 0 );
+		}
+		if( ( int )cursor.quatSegments.size() < quatTracks ){
+			cursor.quatSegments.resize( quatTracks, 0 );
+		}
+		int packets = vec3Values ? ( vec3Tracks + MU_PACKET_SIZE - 1 ) / MU_PACKET_SIZE : 0;
+		MU_PRAGMA( omp parallel for schedule( static ) if( vec3Tracks > MU_PARALLEL_GRAIN ) )
+		for( int packet = 0; packet < packets; packet++ ){
+			int a[ MU_PACKET_SIZE ], b[ MU_PACKET_SIZE ];
+			double f[ MU_PACKET_SIZE ], v[ 3 ][ MU_PACKET_SIZE ];
+			int base = packet * MU_PACKET_SIZE;
+			int lanes = vec3Tracks - base < MU_PACKET_SIZE ? vec3Tracks - base : MU_PACKET_SIZE;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				int track = base + ( i < lanes ? i : 0 );
+				f[ i ] = trackBlend( & m_vec3Times[ 0 ], & m_vec3Offsets[ 0 ], track, time, cursor.vec3Segments[ track ], a[ i ], b[ i ] );
+			}
+			for( int c = 0; c < 3; c++ ){
+				const double * k = & m_vec3Keys[ c ][ 0 ];
+				for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+					v[ c ][ i ] = k[ a[ i ] ] + ( k[ b[ i ] ] - k[ a[ i ] ] ) * f[ i ];
+				}
+			}
+			for( int i = 0; i < lanes; i++ ){
+				vec3Values[ base + i ] = Vec3( v[ 0 ][ i ], v[ 1 ][ i ], v[ 2 ][ i ] );
+			}
+		}
+		packets = quatValues ? ( quatTracks + MU_PACKET_SIZE - 1 ) / MU_PACKET_SIZE : 0;
+		MU_PRAGMA( omp parallel for schedule( static ) if( quatTracks > MU_PARALLEL_GRAIN ) )
+		for( int packet = 0; packet < packets; packet++ ){
+			int a[ MU_PACKET_SIZE ], b[ MU_PACKET_SIZE ];
+			double f[ MU_PACKET_SIZE ], q[ 4 ][ MU_PACKET_SIZE ], scale[ MU_PACKET_SIZE ];
+			int base = packet * MU_PACKET_SIZE;
+			int lanes = quatTracks - base < MU_PACKET_SIZE ? quatTracks - base : MU_PACKET_SIZE;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				int track = base + ( i < lanes ? i : 0 );
+				f[ i ] = trackBlend( & m_quatTimes[ 0 ], & m_quatOffsets[ 0 ], track, time, cursor.quatSegments[ track ], a[ i ], b[ i ] );
+			}
+			for( int c = 0; c < 4; c++ ){
+				const double * k = & m_quatKeys[ c ][ 0 ];
+				for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+					q[ c ][ i ] = k[ a[ i ] ] + ( k[ b[ i ] ] - k[ a[ i ] ] ) * f[ i ];
+				}
+			}
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				scale[ i ] = 1.0 / sqrt( q[ 0 ][ i ] * q[ 0 ][ i ] + q[ 1 ][ i ] * q[ 1 ][ i ] + q[ 2 ][ i ] * q[ 2 ][ i ] + q[ 3 ][ i ] * q[ 3 ][ i ] );
+			}
+			for( int i = 0; i < lanes; i++ ){
+				quatValues[ base + i ] = Quat( q[ 0 ][ i ] * scale[ i ], q[ 1 ][ i ] * scale[ i ], q[ 2 ][ i ] * scale[ i ], q[ 3 ][ i ] * scale[ i ] );
+			}
+		}
+	}
+
+	///--------------------------------animation clips--------------------
+
+	/// smallest three code of a unit quaternion with bits per component, the index of the
+	/// dropped largest component above the three fields and the first field highest. The
+	/// quaternion is negated if need be so that the dropped component decodes as the positive
+	/// square root
+	static uint64_t encodeSmallestThree( const Quat & q, int bits ){
+		int dropped = 0;
+		for( int c = 1; c < 4; c++ ){
+			if( fabs( q[ c ] ) > fabs( q[ dropped ] ) ){
+				dropped = c;
+			}
+		}
+		double sign = q[ dropped ] < 0.0 ? -1.0 : 1.0;
+		double levels = ( double )( ( 1ULL << bits ) - 1 );
+		uint64_t code = dropped;
+		for( int c = 0; c < 4; c++ ){
+			if( c != dropped ){
+				double u = floor( ( sign * q[ c ] * M_SQRT2 + 1.0 ) * 0.5 * levels + 0.5 );
+				code = ( code << bits ) | ( uint64_t )clamp( u, 0.0, levels );
+			}
+		}
+		return( code );
+	}
+
+	static void decodeSmallestThree( uint64_t code, int bits, double * q ){
+		const uint64_t mask = ( 1ULL << bits ) - 1;
+		const double scale = M_SQRT2 / mask;
+		double v[ 3 ];
+		for( int c = 2; c >= 0; c-- ){
+			v[ c ] = ( code & mask ) * scale - M_SQRT1_2;
+			code >>= bits;
+		}
+		int dropped = ( int )( code & 3 );
+		double w = sqrt( largest( 0.0, 1.0 - v[ 0 ] * v[ 0 ] - v[ 1 ] * v[ 1 ] - v[ 2 ] * v[ 2 ] ) );
+		for( int c = 0, j = 0; c < 4; c++ ){
+			q[ c ] = c == dropped ? w : v[ j++ ];
+		}
+	}
+
+	/// distance of key k from the interpolation of keys a and b at its time
+	static double keyDeviation( const double * times, const Vec3 * keys, int a, int b, int k ){
+		double span = times[ b ] - times[ a ];
+		double f = span > 0.0 ? ( times[ k ] - times[ a ] ) / span : 0.0;
+		return( sqrt( ( keys[ a ] + ( keys[ b ] - keys[ a ] ) * f - keys[ k ] ).hyp() ) );
+	}
+
+	/// rotation angle between key k and the normalized lerp of keys a and b at its time
+	static double keyDeviation( const double * times, const Quat * keys, int a, int b, int k ){
+		double span = times[ b ] - times[ a ];
+		double f = span > 0.0 ? ( times[ k ] - times[ a ] ) / span : 0.0;
+		Quat q = keys[ a ] * ( 1.0 - f ) + keys[ b ] * f;
+		q = q / q.len();
+		return( 2.0 * unitAngle( q, q.dot( keys[ k ] ) < 0.0 ? -keys[ k ] : keys[ k ] ) );
+	}
+
+	/// Douglas-Peucker over the key times, a span keeps its worst key while that one deviates
+	/// by more than tolerance from the interpolation across the span
+	template< class T >
+	static void reduceKeys( const double * times, const T * keys, int count, double tolerance, std::vector< int > & kept ){
+		std::vector< char > keep( count, 0 );
+		keep[ 0 ] = keep[ count - 1 ] = 1;
+		std::vector< std::pair< int, int > > spans;
+		if( count > 2 ){
+			spans.push_back( std::make_pair( 0, count - 1 ) );
+		}
+		while( !spans.empty() ){
+			int a = spans.back().first;
+			int b = spans.back().second;
+			spans.pop_back();
+			int worst = -1;
+			double error = tolerance;
+			for( int k = a + 1; k < b; k++ ){
+				double e = keyDeviation( times, keys, a, b, k );
+				if( e > error ){
+					error = e;
+					worst = k;
+				}
+			}
+			if( worst < 0 ){
+				continue;
+			}
+			keep[ worst ] = 1;
+			if( worst - a > 1 ){
+				spans.push_back( std::make_pair( a, worst ) );
+			}
+			if( b - worst > 1 ){
+				spans.push_back( std::make_pair( worst, b ) );
+			}
+		}
+		kept.clear();
+		for( int k = 0; k < count; k++ ){
+			if( keep[ k ] ){
+				kept.push_back( k );
+			}
+		}
+	}
+
+	static uint64_t joinWords( const std::vector< uint16_t > * words, int k ){
+		return( ( ( uint64_t )words[ 0 ][ k ] << 32 ) | ( ( uint64_t )words[ 1 ][ k ] << 16 ) | words[ 2 ][ k ] );
+	}
+
+	AnimationClip::AnimationClip( void ) :
+		m_vec3Offsets( 1, 0 ),
+		m_quatOffsets( 1, 0 ){
+	}
+
+	/// returns the track index, or -1 for a track without keys
+	int AnimationClip::addTrack( const double * times, const Vec3 * keys, int count, double tolerance ){
+		if( count < 1 ){
+			return( -1 );
+		}
+		std::vector< int > kept;
+		reduceKeys( times, keys, count, tolerance, kept );
+		for( int c = 0; c < 3; c++ ){
+			double lo = HUGE_VAL, hi = -HUGE_VAL;
+			for( size_t j = 0; j < kept.size(); j++ ){
+				lo = smallest( lo, keys[ kept[ j ] ][ c ] );
+				hi = largest( hi, keys[ kept[ j ] ][ c ] );
+			}
+			double step = ( hi - lo ) / 65535.0;
+			for( size_t j = 0; j < kept.size(); j++ ){
+				double u = step > 0.0 ? floor( ( keys[ kept[ j ] ][ c ] - lo ) / step + 0.5 ) : 0.0;
+				m_vec3Keys[ c ].push_back( ( uint16_t )clamp( u, 0.0, 65535.0 ) );
+			}
+			m_vec3Origins[ c ].push_back( lo );
+			m_vec3Steps[ c ].push_back( step );
+		}
+		for( size_t j = 0; j < kept.size(); j++ ){
+			m_vec3Times.push_back( ( float )times[ kept[ j ] ] );
+		}
+		m_vec3Offsets.push_back( ( int )m_vec3Times.size() );
+		return( vec3TrackCount() - 1 );
+	}
+
+	int AnimationClip::addTrack( const double * times, const Quat * keys, int count, double tolerance ){
+		if( count < 1 ){
+			return( -1 );
+		}
+		std::vector< Quat > aligned( count );
+		for( int i = 0; i < count; i++ ){
+			aligned[ i ] = keys[ i ].normalized();
+			if( i > 0 && aligned[ i ].dot( aligned[ i - 1 ] ) < 0.0 ){
+				aligned[ i ] = -aligned[ i ];
+			}
+		}
+		std::vector< int > kept;
+		reduceKeys( times, & aligned[ 0 ], count, tolerance, kept );
+		for( size_t j = 0; j < kept.size(); j++ ){
+			uint64_t code = encodeSmallestThree( aligned[ kept[ j ] ], 15 );
+			m_quatTimes.push_back( ( float )times[ kept[ j ] ] );
+			m_quatKeys[ 0 ].push_back( ( uint16_t )( code >> 32 ) );
+			m_quatKeys[ 1 ].push_back( ( uint16_t )( code >> 16 ) );
+			m_quatKeys[ 2 ].push_back( ( uint16_t )code );
+		}
+		m_quatOffsets.push_back( ( int )m_quatTimes.size() );
+		return( quatTrackCount() - 1 );
+	}
+
+	int AnimationClip::vec3TrackCount( void ) const {
+		return( ( int )m_vec3Offsets.size() - 1 );
+	}
+
+	int AnimationClip::quatTrackCount( void ) const {
+		return( ( int )m_quatOffsets.size() - 1 );
+	}
+
+	int AnimationClip::vec3KeyCount( int track ) const {
+		return( m_vec3Offsets[ track + 1 ] - m_vec3Offsets[ track ] );
+	}
+
+	int AnimationClip::quatKeyCount( int track ) const {
+		return( m_quatOffsets[ track + 1 ] - m_quatOffsets[ track ] );
+	}
+
+	/// bytes held by the key, time and range arrays
+	int AnimationClip::byteSize( void ) const {
+		size_t bytes = ( m_vec3Times.size() + m_quatTimes.size() ) * sizeof( float );
+		bytes += ( m_vec3Offsets.size() + m_quatOffsets.size() ) * sizeof( int );
+		for( int c = 0; c < 3; c++ ){
+			bytes += ( m_vec3Keys[ c ].size() + m_quatKeys[ c ].size() ) * sizeof( uint16_t );
+			bytes += ( m_vec3Origins[ c ].size() + m_vec3Steps[ c ].size() ) * sizeof( double );
+		}
+		return( ( int )bytes );
+	}
+
+	/// the kept keys of a track, times may be null
+	void AnimationClip::decompress( int track, double * times, Vec3 * keys ) const {
+		int first = m_vec3Offsets[ track ];
+		int count = vec3KeyCount( track );
+		for( int i = 0; i < count; i++ ){
+			for( int c = 0; c < 3; c++ ){
+				keys[ i ][ c ] = m_vec3Origins[ c ][ track ] + m_vec3Steps[ c ][ track ] * m_vec3Keys[ c ][ first + i ];
+			}
+			if( times ){
+				times[ i ] = m_vec3Times[ first + i ];
+			}
+		}
+	}
+
+	void AnimationClip::decompress( int track, double * times, Quat * keys ) const {
+		int first = m_quatOffsets[ track ];
+		int count = quatKeyCount( track );
+		for( int i = 0; i < count; i++ ){
+			decodeSmallestThree( joinWords( m_quatKeys, first + i ), 15, keys[ i ] );
+			if( times ){
+				times[ i ] = m_quatTimes[ first + i ];
+			}
+		}
+	}
+
+	/// every track at one time, either output may be null to skip that kind of track
+	void AnimationClip::sample( double time, AnimationTracks::Cursor & cursor, Vec3 * vec3Values, Quat * quatValues ) const {
+		int vec3Tracks = vec3TrackCount();
+		int quatTracks = quatTrackCount();
+		if( ( int )cursor.vec3Segments.size() < vec3Tracks ){
+			cursor.vec3Segments.resize( vec3Tracks, 0 );
+		}
+		if( ( int )cursor.quatSegments.size() < quatTracks ){
+			cursor.quatSegments.resize( quatTracks, 0 );
+		}
+		int packets = vec3Values ? ( vec3Tracks + MU_PACKET_SIZE - 1 ) / MU_PACKET_SIZE : 0;
+		MU_PRAGMA( omp parallel for schedule( static ) if( vec3Tracks > MU_PARALLEL_GRAIN ) )
+		for( int packet = 0; packet < packets; packet++ ){
+			int a[ MU_PACKET_SIZE ], b[ MU_PACKET_SIZE ], track[ MU_PACKET_SIZE ];
+			double f[ MU_PACKET_SIZE ], v[ 3 ][ MU_PACKET_SIZE ];
+			int base = packet * MU_PACKET_SIZE;
+			int lanes = vec3Tracks - base < MU_PACKET_SIZE ? vec3Tracks - base : MU_PACKET_SIZE;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				track[ i ] = base + ( i < lanes ? i : 0 );
+				f[ i ] = trackBlend( & m_vec3Times[ 0 ], & m_vec3Offsets[ 0 ], track[ i ], time, cursor.vec3Segments[ track[ i ] ], a[ i ], b[ i ] );
+			}
+			for( int c = 0; c < 3; c++ ){
+				const uint16_t * k = & m_vec3Keys[ c ][ 0 ];
+				const double * origin = & m_vec3Origins[ c ][ 0 ];
+				const double * step = & m_vec3Steps[ c ][ 0 ];
+				for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+					double ka = k[ a[ i ] ], kb = k[ b[ i ] ];
+					v[ c ][ i ] = origin[ track[ i ] ] + step[ track[ i ] ] * ( ka + ( kb - ka ) * f[ i ] );
+				}
+			}
+			for( int i = 0; i < lanes; i++ ){
+				vec3Values[ base + i ] = Vec3( v[ 0 ][ i ], v[ 1 ][ i ], v[ 2 ][ i ] );
+			}
+		}
+		packets = quatValues ? ( quatTracks + MU_PACKET_SIZE - 1 ) / MU_PACKET_SIZE : 0;
+		MU_PRAGMA( omp parallel for schedule( static ) if( quatTracks > MU_PARALLEL_GRAIN ) )
+		for( int packet = 0; packet < packets; packet++ ){
+			int a[ MU_PACKET_SIZE ], b[ MU_PACKET_SIZE ];
+			double f[ MU_PACKET_SIZE ], qa[ MU_PACKET_SIZE ][ 4 ], qb[ MU_PACKET_SIZE ][ 4 ], q[ 4 ][ MU_PACKET_SIZE ], scale[ MU_PACKET_SIZE ];
+			int base = packet * MU_PACKET_SIZE;
+			int lanes = quatTracks - base < MU_PACKET_SIZE ? quatTracks - base : MU_PACKET_SIZE;
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				int track = base + ( i < lanes ? i : 0 );
+				f[ i ] = trackBlend( & m_quatTimes[ 0 ], & m_quatOffsets[ 0 ], track, time, cursor.quatSegments[ track ], a[ i ], b[ i ] );
+				decodeSmallestThree( joinWords( m_quatKeys, a[ i ] ), 15, qa[ i ] );
+				decodeSmallestThree( joinWords( m_quatKeys, b[ i ] ), 15, qb[ i ] );
+			}
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				double d = qa[ i ][ 0 ] * qb[ i ][ 0 ] + qa[ i ][ 1 ] * qb[ i ][ 1 ] + qa[ i ][ 2 ] * qb[ i ][ 2 ] + qa[ i ][ 3 ] * qb[ i ][ 3 ];
+				scale[ i ] = d < 0.0 ? -f[ i ] : f[ i ];
+			}
+			for( int c = 0; c < 4; c++ ){
+				for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+					q[ c ][ i ] = qa[ i ][ c ] * ( 1.0 - f[ i ] ) + qb[ i ][ c ] * scale[ i ];
+				}
+			}
+			for( int i = 0; i < MU_PACKET_SIZE; i++ ){
+				scale[ i ] = 1.0 / sqrt( q[ 0 ][ i ] * q[ 0 ][ i ] + q[ 1 ][ i ] * q[ 1 ][ i ] + q[ 2 ][ i ] * q[ 2 ][ i ] + q[ 3 ][ i ] * q[ 3 ][ i ] );
+			}
+			for( int i = 0; i < lanes; i++ ){
+				quatValues[ base + i ] = Quat( q[ 0 ][ i ] * scale[ i ], q[ 1 ][ i ] * scale[ i ], q[ 2 ][ i ] * scale[ i ], q[ 3 ][ i ] * scale[ i ] );
+			}
+		}
+	}
+
+	///--------------------------------quantization codecs----------------
+
+	/// little endian codes of bytes bytes each
+	static void storeCode( uint64_t code, int bytes, uint8_t * out ){
+		for( int b = 0; b < bytes; b++ ){
+			out[ b ] = ( uint8_t )( code >> ( 8 * b ) );
+		}
+	}
+
+	static uint64_t loadCode( const uint8_t * in, int bytes ){
+		uint64_t code = 0;
+		for( int b = bytes - 1; b >= 0; b-- ){
+			code = ( code << 8 ) | in[ b ];
+		}
+		return( code );
+	}
+
+	/// maximum and root mean square over the per chunk maxima and sums of squares
+	static void foldError( const std::vector< double > & partial, int count, QuantizationError * error ){
+		error->maxError = 0.0;
+		double sum = 0.0;
+		for( size_t c = 0; c < partial.size(); c += 2 ){
+			error->maxError = largest( error->maxError, partial[ c ] );
+			sum += partial[ c + 1 ];
+		}
+		error->rmsError = count > 0 ? sqrt( sum / count ) : 0.0;
+	}
+
+	void encodeQuats( const Quat * quats, int count, int bits, uint8_t * codes, QuantizationError * error ){
+		const int component = ( bits - 2 ) / 3;
+		const int bytes = bits / 8;
+		int chunks = count > MU_PARALLEL_GRAIN ? maxThreads() : 1;
+		std::vector< double > partial( 2 * chunks, 0.0 );
+		MU_PRAGMA( omp parallel for schedule( static, 1 ) num_threads( chunks ) )
+		for( int c = 0; c < chunks; c++ ){
+			int lo = ( int )( ( long long )count * c / chunks );
+			int hi = ( int )( ( long long )count * ( c + 1 ) / chunks );
+			for( int i = lo; i < hi; i++ ){
+				Quat q = quats[ i ].normalized();
+				uint64_t code = encodeSmallestThree( q, component );
+				storeCode( code, bytes, codes + ( size_t )i * bytes );
+				if( error ){
+					Quat d;
+					decodeSmallestThree( code, component, d );
+					double e = 2.0 * unitAngle( q, q.dot( d ) < 0.0 ? -d : d );
+					partial[ 2 * c ] = largest( partial[ 2 * c ], e );
+					partial[ 2 * c + 1 ] += e * e;
+				}
+			}
+		}
+		if( error ){
+			foldError( partial, count, error );
+		}
+	}
+
+	void decodeQuats( const uint8_t * codes, int count, int bits, Quat * quats ){
+		const int component = ( bits - 2 ) / 3;
+		const int bytes = bits / 8;
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			decodeSmallestThree( loadCode( codes + ( size_t )i * bytes, bytes ), component, quats[ i ] );
+		}
+	}
+
+	/// unit vector of unfolded octahedron coordinates, the lower half folds back by moving each
+	/// coordinate toward zero by the depth below the equator ( Cigolle et al. )
+	static Vec3 octahedronUnwrap( double x, double y ){
+		double z = 1.0 - fabs( x ) - fabs( y );
+		double t = largest( -z, 0.0 );
+		x += x >= 0.0 ? -t : t;
+		y += y >= 0.0 ? -t : t;
+		double s = 1.0 / sqrt( x * x + y * y + z * z );
+		return( Vec3( x * s, y * s, z * s ) );
+	}
+
+	static Vec3 decodeOctahedral( uint64_t code, int half ){
+		const uint64_t mask = ( 1ULL << half ) - 1;
+		const double scale = 2.0 / mask;
+		return( octahedronUnwrap( ( code >> half ) * scale - 1.0, ( code & mask ) * scale - 1.0 ) );
+	}
+
+	/// the nearest of the four grid points around the projection, plain rounding can be off
+	/// by a cell near the folds
+	static uint64_t encodeOctahedral( const Vec3 & n, int half ){
+		const double levels = ( double )( ( 1ULL << half ) - 1 );
+		double s = fabs( n[ 0 ] ) + fabs( n[ 1 ] ) + fabs( n[ 2 ] );
+		double x = n[ 0 ] / s, y = n[ 1 ] / s;
+		if( n[ 2 ] < 0.0 ){
+			double folded = ( 1.0 - fabs( y ) ) * ( x >= 0.0 ? 1.0 : -1.0 );
+			y = ( 1.0 - fabs( x ) ) * ( y >= 0.0 ? 1.0 : -1.0 );
+			x = folded;
+		}
+		double u = clamp( ( x + 1.0 ) * 0.5 * levels, 0.0, levels );
+		double v = clamp( ( y + 1.0 ) * 0.5 * levels, 0.0, levels );
+		uint64_t best = 0;
+		double bestDot = -HUGE_VAL;
+		for( int k = 0; k < 4; k++ ){
+			uint64_t cu = ( uint64_t )( k & 1 ? ceil( u ) : floor( u ) );
+			uint64_t cv = ( uint64_t )( k & 2 ? ceil( v ) : floor( v ) );
+			uint64_t code = ( cu << half ) | cv;
+			double d = decodeOctahedral( code, half ).dot( n );
+			if( d > bestDot ){
+				bestDot = d;
+				best = code;
+			}
+		}
+		return( best );
+	}
+
+	void encodeNormals( const Vec3 * normals, int count, int bits, uint8_t * codes, QuantizationError * error ){
+		const int half = bits / 2;
+		const int bytes = bits / 8;
+		int chunks = count > MU_PARALLEL_GRAIN ? maxThreads() : 1;
+		std::vector< double > partial( 2 * chunks, 0.0 );
+		MU_PRAGMA( omp parallel for schedule( static, 1 ) num_threads( chunks ) )
+		for( int c = 0; c < chunks; c++ ){
+			int lo = ( int )( ( long long )count * c / chunks );
+			int hi = ( int )( ( long long )count * ( c + 1 ) / chunks );
+			for( int i = lo; i < hi; i++ ){
+				Vec3 n = normals[ i ] * ( 1.0 / sqrt( normals[ i ].hyp() ) );
+				uint64_t code = encodeOctahedral( n, half );
+				storeCode( code, bytes, codes + ( size_t )i * bytes );
+				if( error ){
+					Vec3 d = decodeOctahedral( code, half );
+					double e = atan2( sqrt( n.cross( d ).hyp() ), n.dot( d ) );
+					partial[ 2 * c ] = largest( partial[ 2 * c ], e );
+					partial[ 2 * c + 1 ] += e * e;
+				}
+			}
+		}
+		if( error ){
+			foldError( partial, count, error );
+		}
+	}
+
+	void decodeNormals( const uint8_t * codes, int count, int bits, Vec3 * normals ){
+		const int half = bits / 2;
+		const int bytes = bits / 8;
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			normals[ i ] = decodeOctahedral( loadCode( codes + ( size_t )i * bytes, bytes ), half );
+		}
+	}
+
+	///--------------------------------packed arrays----------------------
+
+	template< class T > struct PackedComponents;
+	template<> struct PackedComponents< Vec2 > { enum { count = 2 }; };
+	template<> struct PackedComponents< Vec3 > { enum { count = 3 }; };
+	template<> struct PackedComponents< Vec4 > { enum { count = 4 }; };
+	template<> struct PackedComponents< Quat > { enum { count = 4 }; };
+
+	static uint32_t floatBits( float value ){
+		uint32_t bits;
+		memcpy( & bits, & value, sizeof( bits ) );
+		return( bits );
+	}
+
+	static float bitsFloat( uint32_t bits ){
+		float value;
+		memcpy( & value, & bits, sizeof( value ) );
+		return( value );
+	}
+
+	/// float to IEEE half rounding to nearest even, overflow goes to infinity and NaNs come back
+	/// quiet ( Giesen )
+	static uint16_t floatToHalf( float value ){
+		uint32_t f = floatBits( value );
+		uint32_t sign = f & 0x80000000u;
+		f ^= sign;
+		uint32_t h;
+		if( f >= 143u << 23 ){
+			h = f > 0x7f800000u ? 0x7e00 : 0x7c00;
+		}
+		else if( f < 113u << 23 ){
+			// subnormal, the float addition rounds the mantissa into place
+			const uint32_t magic = 126u << 23;
+			h = floatBits( bitsFloat( f ) + bitsFloat( magic ) ) - magic;
+		}
+		else{
+			uint32_t odd = ( f >> 13 ) & 1;
+			f += 0xc8000fffu + odd;
+			h = f >> 13;
+		}
+		return( ( uint16_t )( h | ( sign >> 16 ) ) );
+	}
+
+	static float halfToFloat( uint16_t h ){
+		const uint32_t shiftedExponent = 0x7c00u << 13;
+		uint32_t f = ( h & 0x7fffu ) << 13;
+		uint32_t exponent = f & shiftedExponent;
+		f += ( 127u - 15u ) << 23;
+		if( exponent == shiftedExponent ){
+			f += ( 128u - 16u ) << 23;
+		}
+		else if( exponent == 0 ){
+			f = floatBits( bitsFloat( f + ( 1u << 23 ) ) - bitsFloat( 113u << 23 ) );
+		}
+		return( bitsFloat( f | ( ( h & 0x8000u ) << 16 ) ) );
+	}
+
+	static uint16_t floatToBfloat16( float value ){
+		uint32_t f = floatBits( value );
+		if( ( f & 0x7fffffffu ) > 0x7f800000u ){
+			return( ( uint16_t )( ( f >> 16 ) | 0x40 ) );
+		}
+		return( ( uint16_t )( ( f + 0x7fffu + ( ( f >> 16 ) & 1 ) ) >> 16 ) );
+	}
+
+	static float bfloat16ToFloat( uint16_t b ){
+		return( bitsFloat( ( uint32_t )b << 16 ) );
+	}
+
+	/// count doubles to 16 bit floats, four at a time through F16C when available
+	static void packFloats( PackedFormat format, const double * in, int count, uint16_t * out ){
+		int i = 0;
+		if( format == PACKED_BFLOAT16 ){
+			for( ; i < count; i++ ){
+				out[ i ] = floatToBfloat16( ( float )in[ i ] );
+			}
+			return;
+		}
+#if defined( __F16C__ ) && defined( __AVX__ )
+		for( ; i + 4 <= count; i += 4 ){
+			__m128i h = _mm_cvtps_ph( _mm256_cvtpd_ps( _mm256_loadu_pd( in + i ) ), _MM_FROUND_TO_NEAREST_INT );
+			_mm_storel_epi64( ( __m128i * )( out + i ), h );
+		}
+#endif
+		for( ; i < count; i++ ){
+			out[ i ] = floatToHalf( ( float )in[ i ] );
+		}
+	}
+
+	static void unpackFloats( PackedFormat format, const uint16_t * in, int count, double * out ){
+		int i = 0;
+		if( format == PACKED_BFLOAT16 ){
+			for( ; i < count; i++ ){
+				out[ i ] = bfloat16ToFloat( in[ i ] );
+			}
+			return;
+		}
+#if defined( __F16C__ ) && defined( __AVX__ )
+		for( ; i + 4 <= count; i += 4 ){
+			__m128 f = _mm_cvtph_ps( _mm_loadl_epi64( ( const __m128i * )( in + i ) ) );
+			_mm256_storeu_pd( out + i, _mm256_cvtps_pd( f ) );
+		}
+#endif
+		for( ; i < count; i++ ){
+			out[ i ] = halfToFloat( in[ i ] );
+		}
+	}
+
+	template< class T >
+	PackedArray< T >::PackedArray( PackedFormat format ) :
+		m_format( format ){
+	}
+
+	template< class T >
+	PackedArray< T >::PackedArray( const T * values, int count, PackedFormat format ) :
+		m_format( format ){
+		assign( values, count );
+	}
+
+	template< class T >
+	PackedFormat PackedArray< T >::format( void ) const {
+		return( m_format );
+	}
+
+	template< class T >
+	int PackedArray< T >::size( void ) const {
+		return( ( int )m_bits.size() / PackedComponents< T >::count );
+	}
+
+	template< class T >
+	int PackedArray< T >::byteSize( void ) const {
+		return( ( int )( m_bits.size() * sizeof( uint16_t ) ) );
+	}
+
+	/// new elements are zero
+	template< class T >
+	void PackedArray< T >::resize( int count ){
+		m_bits.resize( ( size_t )count * PackedComponents< T >::count, 0 );
+	}
+
+	template< class T >
+	const uint16_t * PackedArray< T >::data( void ) const {
+		return( m_bits.empty() ? 0 : & m_bits[ 0 ] );
+	}
+
+	template< class T >
+	uint16_t * PackedArray< T >::data( void ){
+		return( m_bits.empty() ? 0 : & m_bits[ 0 ] );
+	}
+
+	template< class T >
+	T PackedArray< T >::get( int index ) const {
+		T value;
+		unpack( index, 1, & value );
+		return( value );
+	}
+
+	template< class T >
+	void PackedArray< T >::set( int index, const T & value ){
+		pack( index, & value, 1 );
+	}
+
+	template< class T >
+	void PackedArray< T >::assign( const T * values, int count ){
+		m_bits.resize( ( size_t )count * PackedComponents< T >::count );
+		pack( 0, values, count );
+	}
+
+	/// elements first .. first + count - 1 from values, the array must hold them. Tightly
+	/// packed element types convert as one stream of doubles in blocks across threads
+	template< class T >
+	void PackedArray< T >::pack( int first, const T * values, int count ){
+		const int n = PackedComponents< T >::count;
+		if( sizeof( T ) == n * sizeof( double ) ){
+			const double * in = values[ 0 ];
+			int total = count * n;
+			int blocks = ( total + MU_PARALLEL_GRAIN - 1 ) / MU_PARALLEL_GRAIN;
+			MU_PRAGMA( omp parallel for schedule( static ) if( blocks > 1 ) )
+			for( int b = 0; b < blocks; b++ ){
+				int lo = b * MU_PARALLEL_GRAIN;
+				int length = total - lo < MU_PARALLEL_GRAIN ? total - lo : MU_PARALLEL_GRAIN;
+				packFloats( m_format, in + lo, length, & m_bits[ ( size_t )first * n + lo ] );
+			}
+			return;
+		}
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			packFloats( m_format, values[ i ], n, & m_bits[ ( size_t )( first + i ) * n ] );
+		}
+	}
+
+	template< class T >
+	void PackedArray< T >::unpack( int first, int count, T * values ) const {
+		const int n = PackedComponents< T >::count;
+		if( sizeof( T ) == n * sizeof( double ) ){
+			double * out = values[ 0 ];
+			int total = count * n;
+			int blocks = ( total + MU_PARALLEL_GRAIN - 1 ) / MU_PARALLEL_GRAIN;
+			MU_PRAGMA( omp parallel for schedule( static ) if( blocks > 1 ) )
+			for( int b = 0; b < blocks; b++ ){
+				int lo = b * MU_PARALLEL_GRAIN;
+				int length = total - lo < MU_PARALLEL_GRAIN ? total - lo : MU_PARALLEL_GRAIN;
+				unpackFloats( m_format, & m_bits[ ( size_t )first * n + lo ], length, out + lo );
+			}
+			return;
+		}
+		MU_PRAGMA( omp parallel for schedule( static ) if( count > MU_PARALLEL_GRAIN ) )
+		for( int i = 0; i < count; i++ ){
+			unpackFloats( m_format, & m_bits[ ( size_t )( first + i ) * n ], n, values[ i ] );
+		}
+	}
+
+	template class PackedArray< Vec2 >;
+	template class PackedArray< Vec3 >;
+	template class PackedArray< Vec4 >;
+	template class PackedArray< Quat >;
+
 } // namespace mu
 
 #undef EMIT_WARNING
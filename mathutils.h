@@ -2,8 +2,10 @@
 #define MATH_UTILS_H
 
 #include <vector>
+#include <map>
 #include <math.h>
 #include <limits.h>
+#include <stdint.h>
 #include <iostream>
 
 #ifndef M_PI
@@ -12,6 +14,11 @@
 
 #define MU_EPSILON 1e-6
 
+/// number of rays or primitives processed per pass by the packet kernels
+#ifndef MU_PACKET_SIZE
+#   define MU_PACKET_SIZE 4
+#endif
+
 namespace mu {
 
     class Vec2;
@@ -19,8 +26,21 @@ namespace mu {
     class Vec4;
     class Quat;
     class Mat2;
+    class Affine2;
     class Mat3;
     class Mat4;
+    class Ray;
+    class RaySegment;
+    class KdTree;
+    class SpatialHashGrid;
+    class Icp;
+    class Obb;
+    class Sphere;
+    class PolygonLocator;
+    class MapProjection;
+    class Squad;
+    class AnimationTracks;
+    class AnimationClip;
 
     double   largest( double, double );
     double   smallest( double, double );
@@ -212,6 +232,39 @@ namespace mu {
             double               m_v[4];
     };
 
+    /// 2D affine transform, x' = linear * x + translation
+    class Affine2 {
+        public:
+                                Affine2( const Mat2 & linear = Mat2(), const Vec2 & translation = Vec2( 0.0 ) );
+
+            Vec2                operator * ( const Vec2 & ) const;
+            Affine2             operator * ( const Affine2 & ) const;
+            Affine2 &           operator *= ( const Affine2 & );
+
+            Mat2 &              linear( void );
+            const Mat2 &        linear( void ) const;
+            Vec2 &              translation( void );
+            const Vec2 &        translation( void ) const;
+            Vec2                transformVector( const Vec2 & ) const;
+            Affine2             inverse( void ) const;
+            Mat3                toMat3( void ) const;
+
+            /// scales first, then rotates counterclockwise, then translates
+            static Affine2      fromRotateScaleTranslate( double radians, const Vec2 & scale, const Vec2 & translation );
+
+        private:
+            Mat2                m_linear;
+            Vec2                m_translation;
+    };
+
+    /// batched Affine2 paths. The first transform applies one transform to every point, the
+    /// second every transform to the same local points ( e.g. sprite corners ), writing
+    /// out[ i * localCount + j ] = transforms[ i ] * local[ j ]. compose writes a[ i ] * b[ i ].
+    void        transform( const Affine2 & transform, const Vec2 * points, int count, Vec2 * out );
+    void        transform( const Affine2 * transforms, int transformCount, const Vec2 * local, int localCount, Vec2 * out );
+    void        compose( const Affine2 * a, const Affine2 * b, int count, Affine2 * out );
+    void        fromRotateScaleTranslate( const double * radians, const Vec2 * scales, const Vec2 * translations, int count, Affine2 * out );
+
     class Vec3 {
         public:
                                 Vec3( double xyz = 0.0f );
@@ -307,6 +360,8 @@ namespace mu {
             double               trace( void ) const;
             double               determinant( void ) const;
             Mat3                inverse( void ) const;
+            void                eigenSymmetric( Vec3 & eigenvalues, Mat3 & eigenvectors ) const;
+            void                svd( Mat3 & u, Vec3 & sigma, Mat3 & v ) const;
             void                scale( const Vec3 & b );
             void                setScaling( const Vec3 & b );
             Vec3                getScaling( void );
@@ -511,6 +566,7 @@ namespace mu {
             Vec4                toPlaneEquation( void ) const;
             Vec3                toYawPitchRollInDegrees( void ) const;
             Quat                toQuat( void );
+            void                decompose( Vec3 & translation, Quat & rotation, Vec3 & scale, Vec3 & shear ) const;
 
             double &             getElement( int column, int row );
             void                setElement( int col, int row, double v );
@@ -549,6 +605,7 @@ namespace mu {
             static Mat4         fromPolar( const Vec4 & xyVectors );
             static Mat4         fromTransformation( const Vec3 & position, const Mat3 & rotation, const Vec3 & scaling = Vec3( 1.0 ) );
             static Mat4         fromTransformation( const Vec3 & position, const Vec3 & YawPitchRollInDegrees, const Vec3 & scaling = Vec3( 1.0 ) );
+            static Mat4         fromDecomposition( const Vec3 & translation, const Quat & rotation, const Vec3 & scale, const Vec3 & shear = Vec3( 0.0 ) );
             static Mat4         fromTranslation( const Vec3 & translation );
             static Mat4         fromRotation( double degrees, const Vec3 & axis );
             static Mat4         fromScaling( const Vec3 & scaling );
@@ -566,6 +623,608 @@ namespace mu {
             double               m_v[16];
     };
 
+    class Ray {
+        public:
+                                Ray( const Vec3 & origin = Vec3( 0.0 ), const Vec3 & direction = Vec3( 0.0, 0.0, 1.0 ) );
+
+            Vec3 &              origin( void );
+            const Vec3 &        origin( void ) const;
+            Vec3 &              direction( void );
+            const Vec3 &        direction( void ) const;
+            Vec3                at( double t ) const;
+            bool                intersectTriangle( const Vec3 & v0, const Vec3 & v1, const Vec3 & v2, double & t, double & u, double & v ) const;
+            bool                intersectBox( const Vec3 & boxMin, const Vec3 & boxMax, double & tNear, double & tFar ) const;
+
+        private:
+            Vec3                m_origin;
+            Vec3                m_direction;
+    };
+
+    /// finite ray running from start ( t = 0 ) to end ( t = 1 )
+    class RaySegment {
+        public:
+                                RaySegment( const Vec3 & start = Vec3( 0.0 ), const Vec3 & end = Vec3( 0.0 ) );
+
+            Vec3 &              start( void );
+            const Vec3 &        start( void ) const;
+            Vec3 &              end( void );
+            const Vec3 &        end( void ) const;
+            Vec3                direction( void ) const;
+            double              length( void ) const;
+            Vec3                at( double t ) const;
+            Ray                 toRay( void ) const;
+            bool                intersectTriangle( const Vec3 & v0, const Vec3 & v1, const Vec3 & v2, double & t, double & u, double & v ) const;
+            bool                intersectBox( const Vec3 & boxMin, const Vec3 & boxMax, double & tNear, double & tFar ) const;
+
+        private:
+            Vec3                m_start;
+            Vec3                m_end;
+    };
+
+    /// packet kernels, MU_PACKET_SIZE rays or primitives per pass. Triangles are read from
+    /// vertices through indices ( three per triangle ), or as consecutive vertex triplets when
+    /// indices is 0. The single ray variants return the index of the closest hit or -1, the
+    /// many ray variants write the hit distance per ray and -1.0 on a miss. Box distances are
+    /// clamped to 0.0 when the ray starts inside the box.
+    int     intersectTriangles( const Ray &, const Vec3 * vertices, const int * indices, int triangleCount, double & t, double & u, double & v );
+    int     intersectTriangles( const RaySegment &, const Vec3 * vertices, const int * indices, int triangleCount, double & t, double & u, double & v );
+    void    intersectTriangle( const Ray * rays, int rayCount, const Vec3 & v0, const Vec3 & v1, const Vec3 & v2, double * t );
+    void    intersectTriangle( const RaySegment * segments, int segmentCount, const Vec3 & v0, const Vec3 & v1, const Vec3 & v2, double * t );
+    int     intersectBoxes( const Ray &, const Vec3 * boxMin, const Vec3 * boxMax, int boxCount, double * tNear );
+    int     intersectBoxes( const RaySegment &, const Vec3 * boxMin, const Vec3 * boxMax, int boxCount, double * tNear );
+    void    intersectBox( const Ray * rays, int rayCount, const Vec3 & boxMin, const Vec3 & boxMax, double * tNear );
+    void    intersectBox( const RaySegment * segments, int segmentCount, const Vec3 & boxMin, const Vec3 & boxMax, double * tNear );
+
+    /// balanced k-d tree over a Vec3 point set, stored implicitly: the node of the range
+    /// [ lo, hi ) is the point in the middle of that range, its children are the two halves.
+    /// Query results are indices into the array the tree was built from.
+    class KdTree {
+        public:
+                                KdTree( void );
+                                KdTree( const Vec3 * points, int count );
+
+            void                build( const Vec3 * points, int count );
+            int                 size( void ) const;
+            int                 nearest( const Vec3 & query, double * distance2 = 0 ) const;
+            int                 nearest( const Vec3 & query, int k, int * indices, double * distances2 ) const;
+            int                 radius( const Vec3 & query, double radius, std::vector< int > & indices ) const;
+            void                nearest( const Vec3 * queries, int queryCount, int k, int * indices, double * distances2 ) const;
+            void                radius( const Vec3 * queries, int queryCount, double radius, std::vector< std::vector< int > > & indices ) const;
+
+        private:
+            std::vector< Vec3 >             m_points;
+            std::vector< int >              m_indices;
+            std::vector< unsigned char >    m_axes;
+    };
+
+    /// uniform grid over quantized Vec3 cells, hashed into a table of buckets. Intended for
+    /// point sets that move every frame: rebuild() is a counting sort by bucket and costs
+    /// O( n ). Query results are indices into the array passed to the last rebuild().
+    class SpatialHashGrid {
+        public:
+                                SpatialHashGrid( double cellSize = 1.0 );
+
+            void                setCellSize( double cellSize );
+            double              getCellSize( void ) const;
+            void                rebuild( const Vec3 * points, int count, int tableSize = 0 );
+            int                 size( void ) const;
+            int                 neighbours( const Vec3 & query, double radius, std::vector< int > & indices ) const;
+            void                neighbours( double radius, std::vector< int > & offsets, std::vector< int > & indices ) const;
+
+        private:
+            unsigned int        bucket( const Vec3 & ) const;
+            void                gatherBuckets( const Vec3 & query, double radius, std::vector< unsigned int > & buckets ) const;
+
+            double                      m_cellSize;
+            double                      m_inverseCellSize;
+            unsigned int                m_mask;
+            std::vector< unsigned int > m_bucketStart;
+            std::vector< int >          m_indices;
+            std::vector< Vec3 >         m_points;
+    };
+
+    /// batched Mat3 decompositions, see Mat3::eigenSymmetric and Mat3::svd
+    void        eigenSymmetric( const Mat3 * matrices, int count, Vec3 * eigenvalues, Mat3 * eigenvectors );
+    void        svd( const Mat3 * matrices, int count, Mat3 * u, Vec3 * sigma, Mat3 * v );
+    void        decompose( const Mat4 * matrices, int count, Vec3 * translations, Quat * rotations, Vec3 * scales, Vec3 * shears );
+
+    /// least squares rigid transform mapping source[ i ] onto target[ i ] ( Kabsch ), with a
+    /// uniform scale when withScale is set ( Umeyama ). Weights are optional, the second form
+    /// returns the rms residual of the fit.
+    Mat4        registerPoints( const Vec3 * source, const Vec3 * target, int count, bool withScale = false, const double * weights = 0 );
+    double      registerPoints( const Vec3 * source, const Vec3 * target, int count, Quat & rotation, Vec3 & translation, double & scale, bool withScale = false, const double * weights = 0 );
+
+    /// statistics of one Icp iteration, times in seconds
+    struct IcpIteration {
+        int                     correspondences;
+        double                  rmsError;
+        double                  searchTime;
+        double                  solveTime;
+    };
+
+    /// iterative closest point alignment of a source cloud onto a target cloud. Every
+    /// iteration matches each transformed source point to its nearest target point, drops
+    /// pairs farther than the maximum distance and the worst trim ratio of the rest, and
+    /// composes the pose with a point-to-point ( Kabsch ) or point-to-plane ( linearized )
+    /// update. Iterations stop once the rms error improves by less than the relative tolerance
+    /// or after the maximum number of updates, whose last pose is measured as well. Every exit
+    /// returns the pose with the lowest rms error seen, which getRmsError then reports.
+    class Icp {
+        public:
+                                Icp( void );
+
+            void                setMaxIterations( int );
+            void                setTolerance( double relativeError );
+            void                setMaxDistance( double );
+            void                setTrimRatio( double );
+            void                setPointToPlane( bool );
+            Mat4                align( const Vec3 * source, int sourceCount, const Vec3 * target, const Vec3 * targetNormals, int targetCount, const Mat4 & initial = Mat4() );
+            Mat4                align( const Vec3 * source, int sourceCount, const KdTree & targetTree, const Vec3 * target, const Vec3 * targetNormals, const Mat4 & initial = Mat4() );
+            bool                converged( void ) const;
+            double              getRmsError( void ) const;
+            const std::vector< IcpIteration > & getIterations( void ) const;
+
+        private:
+            int                             m_maxIterations;
+            double                          m_tolerance;
+            double                          m_maxDistance;
+            double                          m_trimRatio;
+            bool                            m_pointToPlane;
+            bool                            m_converged;
+            double                          m_rmsError;
+            std::vector< IcpIteration >     m_iterations;
+    };
+
+    /// unit normal of every point from the smallest eigenvector of the covariance of its k
+    /// nearest neighbours, flipped to face the viewpoint. The tree has to be built from the
+    /// same points, points with fewer than three neighbours get a zero normal.
+    void        estimateNormals( const Vec3 * points, int count, int k, const Vec3 & viewpoint, Vec3 * normals );
+    void        estimateNormals( const Vec3 * points, int count, const KdTree & tree, int k, const Vec3 & viewpoint, Vec3 * normals );
+
+    /// oriented box, the columns of axes are its unit edge directions ( a rotation ) and
+    /// halfExtents the distances from the centre to the faces along them
+    class Obb {
+        public:
+                                Obb( const Vec3 & center = Vec3( 0.0 ), const Mat3 & axes = Mat3(), const Vec3 & halfExtents = Vec3( 0.0 ) );
+
+            Vec3 &              center( void );
+            const Vec3 &        center( void ) const;
+            Mat3 &              axes( void );
+            const Mat3 &        axes( void ) const;
+            Vec3 &              halfExtents( void );
+            const Vec3 &        halfExtents( void ) const;
+            double              volume( void ) const;
+            bool                contains( const Vec3 & point ) const;
+            void                corners( Vec3 * eightCorners ) const;
+            Mat4                toMat4( void ) const;
+
+            /// box around the points. The fast mode uses the principal axes of the point
+            /// covariance, the hull mode also fixes one axis at a time, fits the minimum area
+            /// rectangle to the convex hull of the projection ( rotating calipers ) and keeps
+            /// the smallest volume. Never larger than the PCA box.
+            static Obb          fromPoints( const Vec3 * points, int count, bool hull = false );
+
+        private:
+            Vec3                m_center;
+            Mat3                m_axes;
+            Vec3                m_halfExtents;
+    };
+
+    /// bounding sphere, containment follows distance2( point, center ) <= radius^2
+    class Sphere {
+        public:
+                                Sphere( const Vec3 & center = Vec3( 0.0 ), double radius = 0.0 );
+
+            Vec3 &              center( void );
+            const Vec3 &        center( void ) const;
+            double &            radius( void );
+            double              radius( void ) const;
+            bool                contains( const Vec3 & point ) const;
+            void                expand( const Vec3 & point );
+
+            /// sphere around the points. The default is Ritter's two pass approximation, at most
+            /// a few percent larger than the optimum. The exact mode runs Welzl's algorithm with
+            /// the move-to-front heuristic in expected O( n ).
+            static Sphere       fromPoints( const Vec3 * points, int count, bool exact = false );
+
+        private:
+            Vec3                m_center;
+            double              m_radius;
+    };
+
+    /// exact sign geometric predicates ( Shewchuk ). The determinant is evaluated in floating
+    /// point first and only recomputed with exact expansion arithmetic when it falls inside
+    /// the rounding error bound, the sign of the result is always correct.
+    /// orient2d > 0 when a, b, c are counterclockwise, orient3d > 0 when d lies below the
+    /// plane through a, b, c ( counterclockwise seen from above ), incircle > 0 when d lies
+    /// inside the circle through counterclockwise a, b, c and insphere > 0 when e lies inside
+    /// the sphere through a, b, c, d with orient3d( a, b, c, d ) > 0. Zero means degenerate.
+    double      orient2d( const Vec2 & a, const Vec2 & b, const Vec2 & c );
+    double      orient3d( const Vec3 & a, const Vec3 & b, const Vec3 & c, const Vec3 & d );
+    double      incircle( const Vec2 & a, const Vec2 & b, const Vec2 & c, const Vec2 & d );
+    double      insphere( const Vec3 & a, const Vec3 & b, const Vec3 & c, const Vec3 & d, const Vec3 & e );
+
+    /// convex hull of the points ( quickhull ), three indices into points per triangle, wound
+    /// counterclockwise seen from outside. Visibility is decided exactly with orient3d, points
+    /// on a face plane count as inside and coplanar facets may be split into several triangles.
+    /// Returns the triangle count, 0 for fewer than four points or flat input.
+    int         convexHull( const Vec3 * points, int count, std::vector< int > & triangles );
+
+    /// Delaunay triangulation of the points, three indices into points per counterclockwise
+    /// triangle. Half-edge e runs from triangles[ e ] to triangles[ e % 3 == 2 ? e - 2 : e + 1 ]
+    /// and halfedges[ e ] is the opposite half-edge in the neighbouring triangle, -1 on the
+    /// convex hull. Points are inserted in Hilbert order with exact predicates, duplicates
+    /// are skipped. Returns the triangle count, 0 when all points are collinear.
+    int         delaunay( const Vec2 * points, int count, std::vector< int > & triangles, std::vector< int > & halfedges );
+
+    /// even-odd point-in-polygon queries against fixed rings. The edges are binned into
+    /// horizontal slabs, so a query only tests the few edges crossing its slab. Rings are given
+    /// as consecutive vertex runs, ringStarts holds ringCount + 1 offsets, holes are rings too.
+    class PolygonLocator {
+        public:
+                                PolygonLocator( void );
+                                PolygonLocator( const Vec2 * vertices, int count, int slabCount = 0 );
+
+            void                build( const Vec2 * vertices, int count, int slabCount = 0 );
+            void                build( const Vec2 * vertices, const int * ringStarts, int ringCount, int slabCount = 0 );
+            bool                contains( const Vec2 & point ) const;
+            void                contains( const Vec2 * points, int count, bool * inside ) const;
+
+        private:
+            double                      m_minY;
+            double                      m_maxY;
+            double                      m_inverseSlabHeight;
+            std::vector< int >          m_slabStart;
+            std::vector< Vec4 >         m_edges;
+    };
+
+    enum ClipOperation {
+        CLIP_INTERSECTION,
+        CLIP_UNION,
+        CLIP_DIFFERENCE
+    };
+
+    /// Sutherland-Hodgman clipping of any polygon against a convex counterclockwise polygon
+    /// or an axis aligned box. Concave subjects may come out with zero width bridges.
+    void        clipPolygon( const Vec2 * subject, int count, const Vec2 * convexClip, int clipCount, std::vector< Vec2 > & out );
+    void        clipPolygon( const Vec2 * subject, int count, const Vec2 & boxMin, const Vec2 & boxMax, std::vector< Vec2 > & out );
+
+    /// boolean operation between two simple polygons of any shape ( Greiner-Hormann ), the
+    /// difference is subject minus clip. Inputs may wind either way, results are separate
+    /// counterclockwise rings and a hole left by a difference is returned as a clockwise ring
+    /// after its outer ring. Repeated consecutive vertices are dropped, out stays empty if the
+    /// rings cannot be put in general position.
+    void        clipPolygon( const Vec2 * subject, int count, const Vec2 * clip, int clipCount, ClipOperation operation, std::vector< std::vector< Vec2 > > & out );
+
+    /// WGS84 ellipsoid conversions. Geodetic coordinates are ( latitude, longitude, height )
+    /// in radians and metres, ECEF is earth centred earth fixed in metres. ecefToGeodetic
+    /// uses Vermeille's closed form with Bowring iterations near the earth's centre.
+    /// enuFrame maps local east, north, up coordinates at a geodetic position to ECEF, its
+    /// inverse maps ECEF to the local frame.
+    Vec3        geodeticToEcef( const Vec3 & geodetic );
+    Vec3        ecefToGeodetic( const Vec3 & ecef );
+    Mat4        enuFrame( const Vec3 & geodetic );
+    void        geodeticToEcef( const Vec3 * geodetic, int count, Vec3 * ecef );
+    void        ecefToGeodetic( const Vec3 * ecef, int count, Vec3 * geodetic );
+    void        enuFrame( const Vec3 * geodetic, int count, Mat4 * frames );
+
+    /// great circle navigation on the unit sphere, scale distances by the radius. Positions are
+    /// Vec2( latitude, longitude ) in radians or unit Vec3, bearings are radians clockwise
+    /// from north in ( -pi, pi ]. slerp moves along the shorter arc, between antipodes along
+    /// the great circle toward the coordinate axis in which a is smallest. The batch forms run
+    /// in parallel.
+    double      greatCircleDistance( const Vec2 & a, const Vec2 & b );
+    double      greatCircleDistance( const Vec3 & a, const Vec3 & b );
+    double      initialBearing( const Vec2 & from, const Vec2 & to );
+    Vec2        greatCircleDestination( const Vec2 & from, double bearing, double distance );
+    Vec2        slerp( const Vec2 & a, const Vec2 & b, double t );
+    Vec3        slerp( const Vec3 & a, const Vec3 & b, double t );
+    void        greatCircleDistance( const Vec2 * a, const Vec2 * b, int count, double * distances );
+    void        greatCircleDistance( const Vec3 * a, const Vec3 * b, int count, double * distances );
+    void        initialBearing( const Vec2 * from, const Vec2 * to, int count, double * bearings );
+    void        greatCircleDestination( const Vec2 * from, const double * bearings, const double * distances, int count, Vec2 * out );
+    void        slerp( const Vec2 * a, const Vec2 * b, int count, double t, Vec2 * out );
+    void        slerp( const Vec3 * a, const Vec3 * b, int count, double t, Vec3 * out );
+
+    /// map projections on the WGS84 ellipsoid. forward takes Vec2( latitude, longitude ) in
+    /// radians to projected ( easting, northing ) metres and inverse goes back, Vec3 forms pass
+    /// the height through. Web Mercator is EPSG:3857 on the sphere of the semi-major axis, UTM
+    /// uses Krueger's series to sixth order ( Karney ), accurate to well below a millimetre.
+    /// Tiles follow the web map pyramid over [ -pi a, pi a ]^2 in projected metres, x to the
+    /// east and y down from the north edge. A tile's matrix maps projected metres to tile
+    /// pixels and composes with a viewport Mat4. Tiles are cached per projection, the cache
+    /// is not thread safe, fetch them before running the batches.
+    class MapProjection {
+        public:
+            enum Type {
+                WEB_MERCATOR,
+                EQUIRECTANGULAR,
+                UTM
+            };
+
+            struct Tile {
+                int             zoom;
+                int             x;
+                int             y;
+                double          scale;
+                Vec2            origin;
+                Mat4            matrix;
+            };
+
+                                MapProjection( void );
+
+            static MapProjection webMercator( void );
+            static MapProjection equirectangular( double standardParallel = 0.0, double centralMeridian = 0.0 );
+            static MapProjection utm( int zone, bool south = false );
+            static int          utmZone( const Vec2 & geodetic );
+
+            Type                type( void ) const;
+            Vec2                forward( const Vec2 & geodetic ) const;
+            Vec2                inverse( const Vec2 & projected ) const;
+            void                forward( const Vec2 * geodetic, int count, Vec2 * projected ) const;
+            void                inverse( const Vec2 * projected, int count, Vec2 * geodetic ) const;
+            void                forward( const Vec3 * geodetic, int count, Vec3 * projected ) const;
+            void                inverse( const Vec3 * projected, int count, Vec3 * geodetic ) const;
+
+            void                setTileSize( int pixels );
+            const Tile &        tile( int zoom, int x, int y ) const;
+            void                forward( const Tile & tile, const Vec2 * geodetic, int count, Vec2 * pixels ) const;
+
+        private:
+            Type                            m_type;
+            double                          m_centralMeridian;
+            double                          m_parallelScale;
+            double                          m_falseNorthing;
+            double                          m_radius;
+            double                          m_alpha[ 6 ];
+            double                          m_beta[ 6 ];
+            int                             m_tileSize;
+            mutable std::map< uint64_t, Tile > m_tiles;
+    };
+
+    /// piecewise cubic curves over Vec2, Vec3 and Vec4, the parameter t runs over
+    /// [ 0, segmentCount() ] with segment i on [ i, i + 1 ]. catmullRom passes through every
+    /// point with mirrored end tangents, bezier joins n cubic segments from 3n + 1 control
+    /// points and bSpline is the uniform cubic B-spline over its control points. sampleUniform
+    /// evaluates count evenly spaced parameters from 0 to segmentCount() by forward
+    /// differencing. buildArcLengthTable resamples the curve by distance so that the
+    /// distance lookups are O( 1 ), rebuild it after reassigning the curve.
+    template< class T >
+    class CubicSpline {
+        public:
+                                CubicSpline( void );
+
+            static CubicSpline  catmullRom( const T * points, int count );
+            static CubicSpline  bezier( const T * controlPoints, int count );
+            static CubicSpline  bSpline( const T * controlPoints, int count );
+
+            int                 segmentCount( void ) const;
+            T                   evaluate( double t ) const;
+            T                   derivative( double t ) const;
+            void                evaluate( const double * parameters, int count, T * out ) const;
+            void                sampleUniform( int count, T * out ) const;
+
+            void                buildArcLengthTable( int samplesPerSegment = 16 );
+            double              length( void ) const;
+            double              parameterAtDistance( double distance ) const;
+            T                   evaluateAtDistance( double distance ) const;
+            void                evaluateAtDistance( const double * distances, int count, T * out ) const;
+
+        private:
+            std::vector< T >        m_coefficients;
+            std::vector< double >   m_arcParameters;
+            double                  m_length;
+    };
+
+    /// spherical quadrangle interpolation through unit quaternions, continuous in angular
+    /// velocity. Key i sits at parameter i, each key is flipped into the hemisphere of its
+    /// predecessor first. The arc length table measures rotation angle in radians so that
+    /// evaluateAtDistance turns at constant angular speed.
+    class Squad {
+        public:
+                                Squad( void );
+                                Squad( const Quat * keys, int count );
+
+            void                setKeys( const Quat * keys, int count );
+            int                 segmentCount( void ) const;
+            Quat                evaluate( double t ) const;
+            void                evaluate( const double * parameters, int count, Quat * out ) const;
+            void                sampleUniform( int count, Quat * out ) const;
+
+            void                buildArcLengthTable( int samplesPerSegment = 16 );
+            double              length( void ) const;
+            double              parameterAtDistance( double distance ) const;
+            Quat                evaluateAtDistance( double distance ) const;
+            void                evaluateAtDistance( const double * distances, int count, Quat * out ) const;
+
+        private:
+            Quat                evaluateSegment( int segment, double h ) const;
+
+            std::vector< Quat >     m_keys;
+            std::vector< Quat >     m_controls;
+            std::vector< double >   m_keyAngles;
+            std::vector< double >   m_controlAngles;
+            std::vector< double >   m_arcParameters;
+            double                  m_length;
+    };
+
+    /// keyframe tracks of ( time, Vec3 ) and ( time, Quat ) keys with increasing times. Keys
+    /// are stored structure of arrays, one array per component across all tracks. A Cursor
+    /// remembers the segment each track was last sampled in, so playback moving by less than a
+    /// segment finds its keys in O( 1 ) and longer jumps fall back to binary search. Samples
+    /// clamp to the first and last key. Quat keys are aligned to one hemisphere when added and
+    /// interpolated by normalized lerp, track indices count Vec3 and Quat tracks separately.
+    class AnimationTracks {
+        public:
+            struct Cursor {
+                std::vector< int >      vec3Segments;
+                std::vector< int >      quatSegments;
+            };
+
+                                AnimationTracks( void );
+
+            int                 addTrack( const double * times, const Vec3 * keys, int count );
+            int                 addTrack( const double * times, const Quat * keys, int count );
+            int                 vec3TrackCount( void ) const;
+            int                 quatTrackCount( void ) const;
+            double              startTime( void ) const;
+            double              endTime( void ) const;
+
+            Vec3                sampleVec3( int track, double time, Cursor & cursor ) const;
+            Quat                sampleQuat( int track, double time, Cursor & cursor ) const;
+            void                sample( double time, Cursor & cursor, Vec3 * vec3Values, Quat * quatValues ) const;
+
+        private:
+            std::vector< double >   m_vec3Times;
+            std::vector< double >   m_vec3Keys[ 3 ];
+            std::vector< int >      m_vec3Offsets;
+            std::vector< double >   m_quatTimes;
+            std::vector< double >   m_quatKeys[ 4 ];
+            std::vector< int >      m_quatOffsets;
+    };
+
+    /// compressed keyframe clip. Each track first drops the keys that linear interpolation
+    /// between its kept neighbours reproduces within tolerance, a distance for Vec3 tracks and
+    /// a rotation angle in radians for Quat tracks. Rotations are then stored smallest three in
+    /// 48 bits, the largest component dropped and 15 bits for each of the others, Vec3 keys as
+    /// 16 bits per component over the track's range and times in single precision. Quantization
+    /// adds up to half a step on top of the tolerance. Sampling follows AnimationTracks and
+    /// decodes the keys in the lanes of each packet of tracks.
+    class AnimationClip {
+        public:
+                                AnimationClip( void );
+
+            int                 addTrack( const double * times, const Vec3 * keys, int count, double tolerance = 0.0 );
+            int                 addTrack( const double * times, const Quat * keys, int count, double tolerance = 0.0 );
+            int                 vec3TrackCount( void ) const;
+            int                 quatTrackCount( void ) const;
+            int                 vec3KeyCount( int track ) const;
+            int                 quatKeyCount( int track ) const;
+            int                 byteSize( void ) const;
+
+            void                decompress( int track, double * times, Vec3 * keys ) const;
+            void                decompress( int track, double * times, Quat * keys ) const;
+            void                sample( double time, AnimationTracks::Cursor & cursor, Vec3 * vec3Values, Quat * quatValues ) const;
+
+        private:
+            std::vector< float >    m_vec3Times;
+            std::vector< uint16_t > m_vec3Keys[ 3 ];
+            std::vector< int >      m_vec3Offsets;
+            std::vector< double >   m_vec3Origins[ 3 ];
+            std::vector< double >   m_vec3Steps[ 3 ];
+            std::vector< float >    m_quatTimes;
+            std::vector< uint16_t > m_quatKeys[ 3 ];
+            std::vector< int >      m_quatOffsets;
+    };
+
+    /// angular error of a batch encode in radians, the rotation angle between each quaternion
+    /// and its decoded code or the angle between each normal and its decoded code
+    struct QuantizationError {
+        double          maxError;
+        double          rmsError;
+    };
+
+    /// smallest three quaternion codes of 32, 48 or 64 bits, 10, 15 or 20 bits for each
+    /// of the three smallest components and two for the index of the dropped one. Codes take
+    /// bits / 8 bytes each, little endian and back to back. Inputs are normalized first and
+    /// decode with the dropped component positive, so q may come back as -q
+    void        encodeQuats( const Quat * quats, int count, int bits, uint8_t * codes, QuantizationError * error = 0 );
+    void        decodeQuats( const uint8_t * codes, int count, int bits, Quat * quats );
+
+    /// octahedral unit vector codes of 16, 24 or 32 bits, half of them for each coordinate of
+    /// the unfolded octahedron. Encoding picks the nearest of the four surrounding grid points
+    void        encodeNormals( const Vec3 * normals, int count, int bits, uint8_t * codes, QuantizationError * error = 0 );
+    void        decodeNormals( const uint8_t * codes, int count, int bits, Vec3 * normals );
+
+    enum PackedFormat {
+        PACKED_HALF,
+        PACKED_BFLOAT16
+    };
+
+    /// Vec2, Vec3, Vec4 or Quat arrays stored as 16 bit floats, a quarter of the size of the
+    /// doubles. PACKED_HALF is IEEE binary16, 11 significant bits up to 65504. PACKED_BFLOAT16
+    /// keeps the float exponent range with 8 significant bits. Values round to nearest even by
+    /// way of single precision, and the bulk conversions use F16C when the build enables it.
+    /// Components are stored interleaved, data() exposes them for upload or file io
+    template< class T >
+    class PackedArray {
+        public:
+                                PackedArray( PackedFormat format = PACKED_HALF );
+                                PackedArray( const T * values, int count, PackedFormat format = PACKED_HALF );
+
+            PackedFormat        format( void ) const;
+            int                 size( void ) const;
+            int                 byteSize( void ) const;
+            void                resize( int count );
+            const uint16_t *    data( void ) const;
+            uint16_t *          data( void );
+
+            T                   get( int index ) const;
+            void                set( int index, const T & value );
+            void                assign( const T * values, int count );
+            void                pack( int first, const T * values, int count );
+            void                unpack( int first, int count, T * values ) const;
+
+        private:
+            PackedFormat            m_format;
+            std::vector< uint16_t > m_bits;
+    };
+
+    /// space filling curves over 21 bit integer coordinates, x in the lowest bit of each triple
+    uint64_t    mortonEncode( unsigned int x, unsigned int y, unsigned int z );
+    void        mortonDecode( uint64_t code, unsigned int & x, unsigned int & y, unsigned int & z );
+    uint64_t    hilbertEncode( unsigned int x, unsigned int y, unsigned int z );
+    void        hilbertDecode( uint64_t code, unsigned int & x, unsigned int & y, unsigned int & z );
+
+    /// batch variants, points are quantized to a 2^21 grid over [ boxMin, boxMax ] and decode
+    /// to the centre of their grid cell
+    void        mortonEncode( const Vec3 * points, int count, const Vec3 & boxMin, const Vec3 & boxMax, uint64_t * codes );
+    void        mortonDecode( const uint64_t * codes, int count, const Vec3 & boxMin, const Vec3 & boxMax, Vec3 * points );
+    void        hilbertEncode( const Vec3 * points, int count, const Vec3 & boxMin, const Vec3 & boxMax, uint64_t * codes );
+    void        hilbertDecode( const uint64_t * codes, int count, const Vec3 & boxMin, const Vec3 & boxMax, Vec3 * points );
+
+    /// stable LSD radix sort, permutation[ i ] is the index of the i-th smallest key. Floating
+    /// point keys follow IEEE total order, -0.0 before 0.0 and NaNs at the ends
+    void        radixSort( const uint64_t * keys, int count, int * permutation );
+    void        radixSort( const double * keys, int count, int * permutation );
+    void        radixSort( const float * keys, int count, int * permutation );
+
+    /// order of the points by view space depth under modelView, farthest first when
+    /// backToFront, nearest first otherwise. The camera looks down -z as set up by lookAt
+    void        sortByDepth( const Vec3 * points, int count, const Mat4 & modelView, int * permutation, bool backToFront = true );
+
+    /// order of the points along a Morton or Hilbert curve through their bounding box, apply
+    /// it to the positions and any companion attribute arrays with permute()
+    void        spatialOrder( const Vec3 * points, int count, int * permutation, bool hilbert = false );
+    void        permute( void * data, int elementSize, const int * permutation, int count );
+
+    ///--------------------------------inline-------------------------------
+    /// the Vec3 products sit in every inner loop, keep them visible to the compiler
+
+    inline Vec3::Vec3( double x, double y, double z ){
+        m_v[ 0 ] = x;
+        m_v[ 1 ] = y;
+        m_v[ 2 ] = z;
+    }
+
+    inline double Vec3::dot( const Vec3 & b ) const {
+        return( m_v[ 0 ] * b.m_v[ 0 ] + m_v[ 1 ] * b.m_v[ 1 ] + m_v[ 2 ] * b.m_v[ 2 ] );
+    }
+
+    inline Vec3 Vec3::cross( const Vec3 & b ) const {
+        return( Vec3(   m_v[ 1 ] * b.m_v[ 2 ] - m_v[ 2 ] * b.m_v[ 1 ],
+                        m_v[ 2 ] * b.m_v[ 0 ] - m_v[ 0 ] * b.m_v[ 2 ],
+                        m_v[ 0 ] * b.m_v[ 1 ] - m_v[ 1 ] * b.m_v[ 0 ] ) );
+    }
+
+    inline double dot( const Vec3 & v1, const Vec3 & v2 ){
+        return( v1.dot( v2 ) );
+    }
+
+    inline Vec3 cross( const Vec3 & v1, const Vec3 & v2 ){
+        return( v1.cross( v2 ) );
+    }
+
 }// mu
 
 #endif //MATH_UTILS_H